@@ -0,0 +1,284 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _arc_cache_using_std_ 
+#define _arc_cache_using_std_ 
+
+#include <algorithm>
+#include <cassert> 
+#include <cstddef>
+#include <list>
+#include <functional> // for std::function
+
+// Class providing fixed-size (by number of records) 
+// ARC-replacement cache of a function with signature 
+// V f(K), with the same interface as lru_cache_using_std. 
+//
+// ARC (Megiddo & Modha, "ARC: A Self-Tuning, Low Overhead
+// Replacement Cache", FAST 2003) keeps keys seen once (T1) and
+// keys seen at least twice (T2) in separate LRU lists, and
+// remembers (without values) keys recently evicted from each
+// (B1 and B2). A hit in B1 means that T1 should have been
+// larger, and a hit in B2 that T2 should have been; the target
+// size of T1 is adapted accordingly, so the cache tunes itself
+// between recency and frequency.
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class arc_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    // Key access history, most recent at back 
+    typedef std::list<key_type> key_tracker_type;
+
+    // The four lists of ARC 
+    enum list_id { t1, t2, b1, b2 };
+
+    // Cached value, and where its key is in T1 or T2 
+    struct record_type {
+        value_type value;
+        list_id list;
+        typename key_tracker_type::iterator tracker_iterator;
+    };
+
+    // Where an evicted key is in B1 or B2 
+    struct ghost_type {
+        list_id list;
+        typename key_tracker_type::iterator tracker_iterator;
+    };
+
+    typedef MAP<key_type, record_type> key_to_value_type;
+    typedef MAP<key_type, ghost_type> key_to_ghost_type;
+
+    typedef std::function<value_type(const key_type&)> function_type;
+
+    // Constructor specifies the cached function and 
+    // the maximum number of records to be stored 
+    arc_cache_using_std(
+        function_type f,
+        size_t c
+    )
+        : _fn(f)
+        , _capacity(c)
+    {
+        assert(_capacity != 0);
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+
+        // Attempt to find existing record 
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+
+        if (it != _key_to_value.end()) {
+
+            // We do have it: it has now been seen at least
+            // twice, so move it to the back of T2 
+            record_type& record = (*it).second;
+            move_to_back(t2, record.list, record.tracker_iterator);
+            record.list = t2;
+            return record.value;
+        }
+
+        // We don't have it: evaluate function and create
+        // new record 
+        const value_type v = _fn(k);
+        insert(k, v);
+        return v;
+    }
+
+    // Obtain the cached keys, most recently used element 
+    // of T2 at head, least recently used element of T1 at
+    // tail. 
+    // This method is provided purely to support testing. 
+    template <typename IT> void get_keys(IT dst) const {
+        for (list_id l : { t2, t1 }) {
+            typename key_tracker_type::const_reverse_iterator src
+                = _lists[l].rbegin();
+            while (src != _lists[l].rend()) {
+                *dst++ = *src++;
+            }
+        }
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        return _key_to_value.find(k) != _key_to_value.end();
+    }
+
+    // Set a key-value pair that may be missing in the cache;
+    // returns true if the pair was inserted
+    bool set(const key_type& k, const value_type& v) {
+        if (has(k)) {
+            return false;
+        }
+        insert(k, v);
+        return true;
+    }
+
+    // Current target size of T1, which ARC adapts between 0
+    // (favour frequency) and the capacity (favour recency) 
+    size_t get_target_t1_size() const {
+        return _target_t1_size;
+    }
+
+    // Number of keys in each of the four lists 
+    size_t get_list_size(list_id l) const {
+        return _lists[l].size();
+    }
+
+private:
+
+    // Record a fresh key-value pair in the cache 
+    void insert(const key_type& k, const value_type& v) {
+
+        // Method is only called on cache misses 
+        assert(_key_to_value.find(k) == _key_to_value.end());
+
+        const size_t t1_size = _lists[t1].size();
+        const size_t b1_size = _lists[b1].size();
+        const size_t b2_size = _lists[b2].size();
+
+        const typename key_to_ghost_type::iterator ghost
+            = _key_to_ghost.find(k);
+
+        if (ghost != _key_to_ghost.end() && (*ghost).second.list == b1) {
+
+            // Recently evicted from T1: favour recency 
+            const size_t delta = std::max<size_t>(b2_size / b1_size, 1);
+            _target_t1_size = std::min(_capacity, _target_t1_size + delta);
+            replace(false);
+            forget(ghost);
+            add(k, v, t2);
+        }
+        else if (ghost != _key_to_ghost.end()) {
+
+            // Recently evicted from T2: favour frequency 
+            const size_t delta = std::max<size_t>(b1_size / b2_size, 1);
+            _target_t1_size = _target_t1_size > delta ? _target_t1_size - delta : 0;
+            replace(true);
+            forget(ghost);
+            add(k, v, t2);
+        }
+        else {
+
+            // Not seen recently at all 
+            if (t1_size + b1_size == _capacity) {
+                if (t1_size < _capacity) {
+                    forget(_key_to_ghost.find(_lists[b1].front()));
+                    replace(false);
+                }
+                else {
+                    evict(t1, false);
+                }
+            }
+            else {
+                const size_t total = t1_size + b1_size + _lists[t2].size() + b2_size;
+                if (total >= _capacity) {
+                    if (total == 2 * _capacity) {
+                        forget(_key_to_ghost.find(_lists[b2].front()));
+                    }
+                    replace(false);
+                }
+            }
+            add(k, v, t1);
+        }
+    }
+
+    // Make space by evicting the least recently used key of
+    // T1 or T2, depending on the target size of T1 
+    void replace(bool hit_in_b2) {
+        const size_t t1_size = _lists[t1].size();
+        if (t1_size > 0 && (t1_size > _target_t1_size || (hit_in_b2 && t1_size == _target_t1_size))) {
+            evict(t1, true);
+        }
+        else if (!_lists[t2].empty()) {
+            evict(t2, true);
+        }
+    }
+
+    // Purge the least-recently-used element of T1 or T2,
+    // optionally remembering its key in B1 or B2 
+    void evict(list_id l, bool remember) {
+
+        // Assert method is never called when list is empty 
+        assert(!_lists[l].empty());
+
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(_lists[l].front());
+        assert(it != _key_to_value.end());
+
+        if (remember) {
+            const list_id ghost_list = l == t1 ? b1 : b2;
+            typename key_tracker_type::iterator tracker_iterator = _lists[l].begin();
+            move_to_back(ghost_list, l, tracker_iterator);
+            const ghost_type ghost = { ghost_list, tracker_iterator };
+            _key_to_ghost.insert(std::make_pair((*it).first, ghost));
+        }
+        else {
+            _lists[l].pop_front();
+        }
+        _key_to_value.erase(it);
+    }
+
+    // Drop a key from B1 or B2 
+    void forget(typename key_to_ghost_type::iterator ghost) {
+        assert(ghost != _key_to_ghost.end());
+        _lists[(*ghost).second.list].erase((*ghost).second.tracker_iterator);
+        _key_to_ghost.erase(ghost);
+    }
+
+    // Add a record at the back of T1 or T2 
+    void add(const key_type& k, const value_type& v, list_id l) {
+        const typename key_tracker_type::iterator it
+            = _lists[l].insert(_lists[l].end(), k);
+        const record_type record = { v, l, it };
+        _key_to_value.insert(std::make_pair(k, record));
+    }
+
+    // Move a key to the back of a list (possibly another
+    // one); iterators remain valid 
+    void move_to_back(list_id to, list_id from, typename key_tracker_type::iterator it) {
+        _lists[to].splice(_lists[to].end(), _lists[from], it);
+    }
+
+    // The function to be cached 
+    const function_type _fn;
+
+    // Maximum number of key-value pairs to be retained 
+    const size_t _capacity;
+
+    // Target size of T1 ("p" in the paper) 
+    size_t _target_t1_size = 0;
+
+    // T1, T2, B1 and B2, least recently used at front 
+    key_tracker_type _lists[4];
+
+    // Key-to-value lookup for keys in T1 and T2 
+    key_to_value_type _key_to_value;
+
+    // Lookup for keys in B1 and B2 
+    key_to_ghost_type _key_to_ghost;
+};
+
+#endif // _arc_cache_using_std_
@@ -0,0 +1,517 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _concurrent_lru_cache_using_std_ 
+#define _concurrent_lru_cache_using_std_ 
+
+#include "epoch_reclaimer.h"
+#include "fibonacci_hash.h"
+#include <algorithm>
+#include <atomic>
+#include <cassert> 
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <list>
+#include <functional> // for std::function
+#include <memory>
+#include <mutex>
+#include <vector>
+
+// Class providing a fixed-size (by number of records), 
+// thread-safe LRU cache of a function with signature 
+// V f(K), with lock-free lookups. 
+//
+// shared_lru_cache_using_std serializes every call on one
+// mutex. Here, the keys are kept in a hash table whose chains
+// readers walk without locks; writers take one of a number of
+// stripe mutexes, so that writes to different stripes run in
+// parallel. As the cache is bounded, the table never needs to
+// grow. Entries removed from the table are retired to an
+// epoch_reclaimer, and freed only once no reader can still be
+// looking at them. There is still a single LRU list over all
+// keys, guarded by a separate mutex. Hits do not take that
+// mutex: they are recorded in a small per-stripe ring buffer,
+// which is applied to the list when the list mutex happens to
+// be free (try_lock), or when a miss takes it anyway. If the
+// buffer wraps around meanwhile, the oldest hits are lost, so
+// the LRU order is approximate under heavy contention, much
+// like with a promotion_policy.
+//
+// As with shared_lru_cache_using_std, threads that miss the
+// same key at the same time wait for a single evaluation, and
+// share its exception if it throws; an erase(k) during the
+// evaluation keeps its result from being stored, or handed to
+// the waiting threads (which then evaluate k again). None of
+// the optional features of shared_lru_cache_using_std
+// (negative and failure caching, removal listener, erase_if(),
+// statistics) are provided. 
+// Keys are compared with operator==. MAP is one of std::map or
+// std::unordered_map; it only holds the evaluations in
+// progress, as the index is the hash table. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class concurrent_lru_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    typedef std::function<value_type(const key_type&)> function_type;
+
+    // Constructor specifies the cached function, the maximum 
+    // number of records to be stored, and the number of stripes 
+    // (rounded up to a power of two) 
+    concurrent_lru_cache_using_std(
+        function_type f,
+        size_t c,
+        size_t stripes = 16
+    )
+        : _fn(f)
+        , _capacity(c)
+        , _stripe_bits(bits_for(stripes))
+        , _stripes(new stripe[size_t(1) << _stripe_bits])
+        , _bucket_bits(std::max(std::max(bits_for(c), _stripe_bits), 1u))
+        , _buckets(new std::atomic<node*>[size_t(1) << _bucket_bits])
+    {
+        assert(_capacity != 0);
+        for (size_t i = 0, n = size_t(1) << _bucket_bits; i < n; ++i) {
+            _buckets[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    // No thread may be using the cache anymore 
+    ~concurrent_lru_cache_using_std() {
+        for (size_t i = 0, n = size_t(1) << _bucket_bits; i < n; ++i) {
+            node* next = _buckets[i].load(std::memory_order_relaxed);
+            while (next) {
+                node* n = next;
+                next = n->next.load(std::memory_order_relaxed);
+                delete n;
+            }
+        }
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+        const size_t b = bucket_for(k);
+        {
+            epoch_reclaimer::guard pinned(_reclaimer);
+            if (node* n = find(b, k)) {
+                record_access(stripe_for(b), n);
+                return n->value;
+            }
+        }
+
+        for (;;) {
+            std::shared_ptr<evaluation> e;
+            bool evaluating = false;
+            {
+                stripe& s = stripe_for(b);
+                std::lock_guard<std::mutex> guard(s.mutex);
+
+                // The key may have been added meanwhile; its node
+                // cannot be retired while the stripe is locked 
+                if (node* n = find(b, k)) {
+                    return n->value;
+                }
+
+                std::shared_ptr<evaluation>& in_progress = s.evaluations[k];
+                if (!in_progress) {
+                    in_progress = std::make_shared<evaluation>();
+                    evaluating = true;
+                }
+                e = in_progress;
+            }
+
+            if (evaluating) {
+                return evaluate(b, k, e);
+            }
+
+            std::unique_lock<std::mutex> lock(e->mutex);
+            e->done_cv.wait(lock, [&e]() { return e->done; });
+            if (e->failure) {
+                std::rethrow_exception(e->failure);
+            }
+            if (e->value) {
+                return *e->value;
+            }
+
+            // Invalidated while being evaluated: try again 
+        }
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        epoch_reclaimer::guard pinned(_reclaimer);
+        return find(bucket_for(k), k) != nullptr;
+    }
+
+    // Set a key-value pair that may be missing in the cache;
+    // returns true if the pair was inserted
+    bool set(const key_type& k, const value_type& v) {
+        return insert(k, v);
+    }
+
+    // Remove k from the cache; returns true if it was there. An
+    // evaluation of k that is in progress will not store its
+    // result. 
+    bool erase(const key_type& k) {
+        {
+            const size_t b = bucket_for(k);
+            stripe& s = stripe_for(b);
+            std::lock_guard<std::mutex> guard(s.mutex);
+
+            const auto i = s.evaluations.find(k);
+            if (i != s.evaluations.end()) {
+                i->second->invalidated = true;
+            }
+
+            node* n = find(b, k);
+            if (!n) {
+                return false;
+            }
+            unlink_from_bucket(b, n);
+            {
+                std::lock_guard<std::mutex> lru_guard(_lru_mutex);
+                unlink(n);
+            }
+            _reclaimer.retire(n);
+        }
+        collect_garbage();
+        return true;
+    }
+
+    // Number of records in the cache 
+    size_t size() const {
+        std::lock_guard<std::mutex> guard(_lru_mutex);
+        return _key_tracker.size();
+    }
+
+    // Obtain the cached keys, most recently used element 
+    // at head, least recently used at tail, after applying
+    // all buffered hits. 
+    // This method is provided purely to support testing. 
+    template <typename IT> void get_keys(IT dst) {
+        std::lock_guard<std::mutex> lru_guard(_lru_mutex);
+        for (size_t i = 0, n = size_t(1) << _stripe_bits; i < n; ++i) {
+            drain(_stripes[i]);
+        }
+        typename key_tracker_type::const_reverse_iterator src
+            = _key_tracker.rbegin();
+        while (src != _key_tracker.rend()) {
+            *dst++ = (*src++)->key;
+        }
+    }
+
+private:
+
+    struct node;
+
+    // The LRU list, most recent at back 
+    typedef std::list<node*> key_tracker_type;
+
+    struct node {
+        node(const key_type& k, const value_type& v) : key(k), value(v), next(nullptr) {}
+
+        const key_type key;
+        const value_type value;
+
+        // Next node in the same bucket; read without locks, but
+        // written only while holding the stripe mutex 
+        std::atomic<node*> next;
+
+        // Position in the LRU list, if linked; both guarded
+        // by _lru_mutex 
+        typename key_tracker_type::iterator tracker_iterator;
+        bool linked = false;
+    };
+
+    // An evaluation in progress, which the other threads that
+    // miss the same key wait for 
+    struct evaluation {
+        // Set by erase(k); guarded by the stripe mutex until
+        // the evaluation is removed from the stripe 
+        bool invalidated = false;
+
+        // The outcome, guarded by mutex: the value, unless the
+        // evaluation failed or was invalidated 
+        std::mutex mutex;
+        std::condition_variable done_cv;
+        bool done = false;
+        std::unique_ptr<value_type> value;
+        std::exception_ptr failure;
+    };
+
+    // Hits are buffered in a ring of this many per stripe; the
+    // buffer is applied every half round, if the list mutex is
+    // free 
+    static const size_t access_buffer_capacity = 64;
+
+    // Freeing retired nodes is attempted whenever this many
+    // more have been retired 
+    static const size_t reclaim_batch_size = 64;
+
+    struct stripe {
+        stripe() {
+            for (std::atomic<node*>& a : accesses) {
+                a.store(nullptr, std::memory_order_relaxed);
+            }
+        }
+
+        // Serializes changes to the buckets of the stripe, and
+        // guards evaluations 
+        std::mutex mutex;
+
+        // Keys of the stripe being evaluated 
+        MAP<key_type, std::shared_ptr<evaluation> > evaluations;
+
+        std::atomic<node*> accesses[access_buffer_capacity];
+        std::atomic<size_t> next_access { 0 };
+    };
+
+    static unsigned int bits_for(size_t n) {
+        unsigned int bits = 0;
+        while ((size_t(1) << bits) < n) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    size_t bucket_for(const key_type& k) const {
+        return fibonacci_hash(k, _bucket_bits);
+    }
+
+    // There are at least as many buckets as stripes 
+    stripe& stripe_for(size_t bucket) const {
+        return _stripes[bucket & ((size_t(1) << _stripe_bits) - 1)];
+    }
+
+    // Must be called while pinned, or while holding the stripe
+    // mutex of the bucket 
+    node* find(size_t bucket, const key_type& k) const {
+        for (node* n = _buckets[bucket].load(std::memory_order_acquire);
+             n;
+             n = n->next.load(std::memory_order_acquire)) {
+            if (n->key == k) {
+                return n;
+            }
+        }
+        return nullptr;
+    }
+
+    // Remove n from its bucket, if it is still there, leaving
+    // its next pointer intact for readers that are at n; must
+    // be called while holding the stripe mutex of the bucket 
+    bool unlink_from_bucket(size_t bucket, node* n) {
+        std::atomic<node*>* link = &_buckets[bucket];
+        while (node* m = link->load(std::memory_order_relaxed)) {
+            if (m == n) {
+                link->store(n->next.load(std::memory_order_relaxed), std::memory_order_release);
+                return true;
+            }
+            link = &m->next;
+        }
+        return false;
+    }
+
+    // Buffer a hit; must be called while pinned 
+    void record_access(stripe& s, node* n) {
+        const size_t i = s.next_access.fetch_add(1, std::memory_order_relaxed);
+        s.accesses[i % access_buffer_capacity].store(n, std::memory_order_release);
+        if (i % (access_buffer_capacity / 2) == access_buffer_capacity / 2 - 1) {
+            std::unique_lock<std::mutex> lru_lock(_lru_mutex, std::try_to_lock);
+            if (lru_lock.owns_lock()) {
+                drain(s);
+            }
+        }
+    }
+
+    // Apply the buffered hits of s to the LRU list; must be
+    // called while holding _lru_mutex. The buffered nodes may
+    // have been retired, but not yet freed 
+    void drain(stripe& s) {
+        for (std::atomic<node*>& a : s.accesses) {
+            node* n = a.exchange(nullptr, std::memory_order_acquire);
+            if (n && n->linked) {
+                _key_tracker.splice(_key_tracker.end(), _key_tracker, n->tracker_iterator);
+            }
+        }
+    }
+
+    // Must be called while holding _lru_mutex 
+    void unlink(node* n) {
+        if (n->linked) {
+            _key_tracker.erase(n->tracker_iterator);
+            n->linked = false;
+        }
+    }
+
+    // Free the retired nodes that no reader can be using; the
+    // access buffers may still point to them, so they are
+    // drained after the epoch has advanced (when the readers
+    // that buffered such nodes are known to be done), but
+    // before the nodes are freed. Must not be called while
+    // pinned, or the epoch could not advance 
+    void collect_garbage() {
+        if (_reclaimer.retired() < _next_collection.load(std::memory_order_relaxed)) {
+            return;
+        }
+        uint64_t epoch;
+        {
+            std::lock_guard<std::mutex> lru_guard(_lru_mutex);
+            epoch = _reclaimer.advance();
+            for (size_t i = 0, n = size_t(1) << _stripe_bits; i < n; ++i) {
+                drain(_stripes[i]);
+            }
+        }
+        _reclaimer.reclaim(epoch);
+
+        // If a reader stays pinned, nothing can be freed for a
+        // while; do not try again on every call meanwhile 
+        _next_collection.store(_reclaimer.retired() + reclaim_batch_size, std::memory_order_relaxed);
+    }
+
+    // Evaluate k on behalf of all the threads waiting for it 
+    value_type evaluate(size_t b, const key_type& k, const std::shared_ptr<evaluation>& e) {
+        try {
+            const value_type v = _fn(k);
+            insert(k, v, e.get());
+            finish(*e, e->invalidated ? nullptr : &v, nullptr);
+            return v;
+        }
+        catch (...) {
+            stripe& s = stripe_for(b);
+            {
+                std::lock_guard<std::mutex> guard(s.mutex);
+                end_evaluation(s, k, *e);
+            }
+            finish(*e, nullptr, e->invalidated ? nullptr : std::current_exception());
+            throw;
+        }
+    }
+
+    // Remove e from the evaluations in progress, if it is still
+    // there; must be called while holding the stripe mutex 
+    void end_evaluation(stripe& s, const key_type& k, const evaluation& e) {
+        const auto i = s.evaluations.find(k);
+        if (i != s.evaluations.end() && i->second.get() == &e) {
+            s.evaluations.erase(i);
+        }
+    }
+
+    // Hand the outcome of an evaluation to the waiting threads 
+    void finish(evaluation& e, const value_type* v, std::exception_ptr failure) {
+        std::lock_guard<std::mutex> guard(e.mutex);
+        if (e.done) {
+            return;
+        }
+        if (v) {
+            e.value.reset(new value_type(*v));
+        }
+        e.failure = failure;
+        e.done = true;
+        e.done_cv.notify_all();
+    }
+
+    // Add a key-value pair, unless another thread added k 
+    // first, and evict as necessary; returns true if the pair
+    // was added. If the pair is the result of evaluation e, e
+    // is ended, and the pair is not added if e was invalidated. 
+    bool insert(const key_type& k, const value_type& v, evaluation* e = nullptr) {
+        std::vector<node*> evicted;
+        {
+            // Evicted nodes must not be freed (by another
+            // thread erasing them) before they are dealt with
+            // below 
+            epoch_reclaimer::guard pinned(_reclaimer);
+            {
+                const size_t b = bucket_for(k);
+                stripe& s = stripe_for(b);
+                std::lock_guard<std::mutex> guard(s.mutex);
+                if (e) {
+                    end_evaluation(s, k, *e);
+                    if (e->invalidated) {
+                        return false;
+                    }
+                }
+                if (find(b, k)) {
+                    return false;
+                }
+                node* n = new node(k, v);
+                n->next.store(_buckets[b].load(std::memory_order_relaxed), std::memory_order_relaxed);
+
+                std::lock_guard<std::mutex> lru_guard(_lru_mutex);
+                drain(s);
+                n->tracker_iterator = _key_tracker.insert(_key_tracker.end(), n);
+                n->linked = true;
+                _buckets[b].store(n, std::memory_order_release);
+
+                // Unlink the least recently used nodes now, but
+                // remove them from their buckets only after the
+                // mutexes have been released, so that the stripe
+                // mutexes are always taken before _lru_mutex 
+                while (_key_tracker.size() > _capacity) {
+                    evicted.push_back(_key_tracker.front());
+                    unlink(evicted.back());
+                }
+            }
+
+            for (node* n : evicted) {
+                const size_t b = bucket_for(n->key);
+                std::lock_guard<std::mutex> guard(stripe_for(b).mutex);
+
+                // The key may have been erased meanwhile 
+                if (unlink_from_bucket(b, n)) {
+                    _reclaimer.retire(n);
+                }
+            }
+        }
+        collect_garbage();
+        return true;
+    }
+
+    // The function to be cached 
+    const function_type _fn;
+
+    // Maximum number of key-value pairs to be retained 
+    const size_t _capacity;
+
+    const unsigned int _stripe_bits;
+    const std::unique_ptr<stripe[]> _stripes;
+
+    // The hash table; at least as many buckets as the capacity 
+    const unsigned int _bucket_bits;
+    const std::unique_ptr<std::atomic<node*>[]> _buckets;
+
+    // Retired nodes, waiting for readers to move on 
+    mutable epoch_reclaimer _reclaimer;
+    std::atomic<size_t> _next_collection { reclaim_batch_size };
+
+    // The LRU list over all stripes 
+    key_tracker_type _key_tracker;
+
+    // This mutex guards _key_tracker and the list positions
+    // of the nodes; when both are needed, a stripe mutex is
+    // always taken first 
+    mutable std::mutex _lru_mutex;
+};
+
+#endif // _concurrent_lru_cache_using_std_
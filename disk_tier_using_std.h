@@ -0,0 +1,577 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _disk_tier_using_std_ 
+#define _disk_tier_using_std_ 
+
+#include <cassert>
+#include <condition_variable>
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <functional>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+
+// Second cache tier that keeps key-value pairs evicted from
+// an in-memory cache in a local, log-structured file.
+//
+// Evicted pairs are handed over with put(), which only queues
+// them; a background thread appends them to the file in
+// batches. An in-memory index maps keys to their records, and
+// is bounded to a fixed number of keys (the least recently
+// written ones are dropped first). Records that are no longer
+// indexed are reclaimed by compacting the file once they make
+// up more than half of it.
+//
+// Pairs are moved, not copied, back into memory: take()
+// removes the pair from this tier.
+//
+// The file is private to the object: it is truncated when
+// the object is created, and removed when it is destroyed.
+// Thread-safe.
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class disk_tier_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    // Conversions between values and their on-disk records 
+    typedef std::function<std::string(const value_type&)> serializer_type;
+    typedef std::function<value_type(const std::string&)> deserializer_type;
+
+    // Constructor specifies the file to use, the maximum
+    // number of keys to keep there, how values are stored,
+    // and how many queued pairs trigger a write 
+    disk_tier_using_std(
+        const std::string& path,
+        size_t capacity,
+        serializer_type serialize,
+        deserializer_type deserialize,
+        size_t batch_size = 64
+    )
+        : _path(path)
+        , _capacity(capacity)
+        , _serialize(serialize)
+        , _deserialize(deserialize)
+        , _batch_size(batch_size)
+        , _pending(new pending_type)
+    {
+        assert(_capacity != 0);
+        assert(_batch_size != 0);
+
+        _file.open(_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!_file) {
+            throw std::runtime_error("Unable to open disk tier file: " + _path);
+        }
+
+        _writer = std::thread(&disk_tier_using_std::write_loop, this);
+    }
+
+    ~disk_tier_using_std() {
+        {
+            std::lock_guard<std::mutex> guard(_pending_mutex);
+            _stopping = true;
+        }
+        _pending_cv.notify_one();
+        _writer.join();
+
+        _file.close();
+        std::remove(_path.c_str());
+    }
+
+    // Queue a pair to be written to the file. This is cheap
+    // enough to be called from an eviction callback, while
+    // the in-memory cache is locked. 
+    void put(const key_type& k, const value_type& v) {
+        bool batch_full = false;
+        {
+            std::lock_guard<std::mutex> guard(_pending_mutex);
+            (*_pending)[k] = std::make_shared<const value_type>(v);
+            batch_full = _pending->size() >= _batch_size;
+        }
+        if (batch_full) {
+            _pending_cv.notify_one();
+        }
+    }
+
+    // Remove the pair for k from this tier, and return its value
+    // (or nullptr, if this tier does not have k) 
+    std::unique_ptr<value_type> take(const key_type& k) {
+        const std::shared_ptr<const value_type> queued = unqueue(k);
+
+        std::lock_guard<std::mutex> guard(_index_mutex);
+
+        // Any older record is stale now, or is the value itself
+        std::string record;
+        const bool found_in_file = erase_from_index(k, queued ? nullptr : &record);
+
+        if (queued) {
+            return std::unique_ptr<value_type>(new value_type(*queued));
+        }
+        if (found_in_file) {
+            return std::unique_ptr<value_type>(new value_type(_deserialize(record)));
+        }
+        return nullptr;
+    }
+
+    // Remove the pair for k from this tier; returns true if
+    // this tier had k 
+    bool erase(const key_type& k) {
+        const bool queued = static_cast<bool>(unqueue(k));
+
+        std::lock_guard<std::mutex> guard(_index_mutex);
+        return erase_from_index(k, nullptr) || queued;
+    }
+
+    // Remove all pairs for which
+    //     bool pred(const K&, const V&)
+    // returns true. The records in the file are read back for
+    // this, so it takes time proportional to the file size.
+    // Returns the number of pairs removed.
+    template <typename PREDICATE>
+    size_t erase_if(PREDICATE pred) {
+        size_t count = 0;
+        {
+            std::lock_guard<std::mutex> guard(_pending_mutex);
+            for (auto i = _pending->begin(); i != _pending->end(); ) {
+                if (pred(i->first, *i->second)) {
+                    i = _pending->erase(i);
+                    ++count;
+                }
+                else {
+                    ++i;
+                }
+            }
+            if (_writing) {
+                for (auto& i : *_writing) {
+                    if (i.second && pred(i.first, *i.second)) {
+                        i.second = nullptr;
+                        ++count;
+                    }
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(_index_mutex);
+        std::string record;
+        for (auto i = _key_tracker.begin(); i != _key_tracker.end(); ) {
+            const key_type k = *i++;
+            read(_key_to_location.find(k)->second, record);
+            if (pred(k, _deserialize(record))) {
+                erase_from_index(k, nullptr);
+                ++count;
+            }
+        }
+        compact_if_needed();
+        return count;
+    }
+
+    // Remove all pairs 
+    void clear() {
+        {
+            std::lock_guard<std::mutex> guard(_pending_mutex);
+            _pending->clear();
+            if (_writing) {
+                for (auto& i : *_writing) {
+                    i.second = nullptr;
+                }
+            }
+        }
+
+        std::lock_guard<std::mutex> guard(_index_mutex);
+        _key_to_location.clear();
+        _key_tracker.clear();
+        _dead_bytes = _file_size;
+        compact_if_needed();
+    }
+
+    // Write all queued pairs now 
+    void flush() {
+        write_batch();
+    }
+
+    // Number of keys in the file (not counting queued ones) 
+    size_t size() const {
+        std::lock_guard<std::mutex> guard(_index_mutex);
+        return _key_to_location.size();
+    }
+
+    // Size of the file, and how much of it is unused 
+    struct file_usage {
+        uint64_t total_bytes = 0;
+        uint64_t dead_bytes = 0;
+    };
+
+    file_usage get_file_usage() const {
+        std::lock_guard<std::mutex> guard(_index_mutex);
+        file_usage usage;
+        usage.total_bytes = _file_size;
+        usage.dead_bytes = _dead_bytes;
+        return usage;
+    }
+
+private:
+
+    disk_tier_using_std(const disk_tier_using_std&);
+    disk_tier_using_std& operator=(const disk_tier_using_std&);
+
+    // Keys in write order, least recently written at front 
+    typedef std::list<key_type> key_tracker_type;
+
+    struct location {
+        uint64_t offset;
+        uint64_t length;
+        typename key_tracker_type::iterator tracker_iterator;
+    };
+
+    typedef MAP<key_type, location> key_to_location_type;
+
+    typedef MAP<key_type, std::shared_ptr<const value_type> > pending_type;
+
+    void write_loop() {
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> lock(_pending_mutex);
+                _pending_cv.wait(lock, [this]() {
+                    return _stopping || _pending->size() >= _batch_size;
+                });
+                if (_stopping) {
+                    return;
+                }
+            }
+            try {
+                write_batch();
+            }
+            catch (...) {
+                // The batch is lost, which only means that its
+                // values will have to be evaluated again
+            }
+        }
+    }
+
+    // Remove k from the pairs waiting to be written and from
+    // those being written (k is in both if it was put again
+    // during the write), and return its latest value, if it
+    // was there 
+    std::shared_ptr<const value_type> unqueue(const key_type& k) {
+        std::shared_ptr<const value_type> queued;
+        std::lock_guard<std::mutex> guard(_pending_mutex);
+        if (_writing) {
+            const auto j = _writing->find(k);
+            if (j != _writing->end()) {
+                // Being written right now; let the writer
+                // know that it should not be indexed
+                queued = j->second;
+                j->second = nullptr;
+            }
+        }
+        const auto i = _pending->find(k);
+        if (i != _pending->end()) {
+            queued = i->second;
+            _pending->erase(i);
+        }
+        return queued;
+    }
+
+    // Clears _writing when write_batch() returns or throws, so
+    // that a lost batch does not remain visible to take() 
+    struct writing_reset {
+        disk_tier_using_std& tier;
+
+        ~writing_reset() {
+            std::lock_guard<std::mutex> guard(tier._pending_mutex);
+            tier._writing.reset();
+        }
+    };
+
+    // Append the queued pairs to the file and index them 
+    void write_batch() {
+        std::lock_guard<std::mutex> write_guard(_write_mutex);
+        const writing_reset reset = { *this };
+
+        std::vector<std::pair<key_type, std::shared_ptr<const value_type> > > batch;
+        {
+            std::lock_guard<std::mutex> guard(_pending_mutex);
+            if (_pending->empty()) {
+                return;
+            }
+            // Keep the batch visible to take() until indexed
+            _writing.swap(_pending);
+            _pending.reset(new pending_type);
+            batch.assign(_writing->begin(), _writing->end());
+        }
+
+        // Serialize without holding any lock
+        std::vector<std::pair<key_type, std::string> > records;
+        try {
+            records.reserve(batch.size());
+            for (const auto& i : batch) {
+                records.push_back(std::make_pair(i.first, _serialize(*i.second)));
+            }
+        }
+        catch (...) {
+            // The older records of the keys are stale now
+            std::lock_guard<std::mutex> guard(_index_mutex);
+            for (const auto& i : batch) {
+                erase_from_index(i.first, nullptr);
+            }
+            throw;
+        }
+        batch.clear();
+
+        std::lock_guard<std::mutex> guard(_index_mutex);
+
+        // Append after the last good record, checking the stream
+        // after each one; nothing is indexed until all of them
+        // have been flushed 
+        _file.seekp(static_cast<std::streamoff>(_file_size));
+        uint64_t end = _file_size;
+        for (const auto& r : records) {
+            _file.write(r.second.data(), r.second.size());
+            if (!_file) {
+                break;
+            }
+            end += r.second.size();
+        }
+        if (_file) {
+            _file.flush();
+        }
+        if (!_file) {
+            // Whatever was written after _file_size is garbage,
+            // to be overwritten by the next batch; the batch is
+            // lost, and the older records of its keys are stale
+            reopen();
+            for (const auto& r : records) {
+                erase_from_index(r.first, nullptr);
+            }
+            throw std::runtime_error("Unable to write disk tier file: " + _path);
+        }
+
+        uint64_t offset = _file_size;
+        _file_size = end;
+        for (const auto& r : records) {
+            const uint64_t length = r.second.size();
+            bool taken = false;
+            {
+                std::lock_guard<std::mutex> guard(_pending_mutex);
+                taken = !_writing->find(r.first)->second;
+            }
+            if (taken) {
+                // Taken while being written
+                _dead_bytes += length;
+            }
+            else {
+                index(r.first, offset, length);
+            }
+            offset += length;
+        }
+
+        compact_if_needed();
+    }
+
+    // Reopen the file, discarding any buffered output and the
+    // error state of the stream; _index_mutex must be held 
+    void reopen() {
+        _file.close();
+        _file.clear();
+        _file.open(_path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!_file) {
+            throw std::runtime_error("Unable to open disk tier file: " + _path);
+        }
+    }
+
+    // Record where the value for k is; _index_mutex must be held 
+    void index(const key_type& k, uint64_t offset, uint64_t length) {
+        erase_from_index(k, nullptr);
+
+        if (_key_to_location.size() == _capacity) {
+            erase_from_index(_key_tracker.front(), nullptr);
+        }
+
+        const typename key_tracker_type::iterator it
+            = _key_tracker.insert(_key_tracker.end(), k);
+        const location loc = { offset, length, it };
+        _key_to_location.insert(std::make_pair(k, loc));
+    }
+
+    // Drop k from the index, optionally reading its record 
+    // first; _index_mutex must be held 
+    bool erase_from_index(const key_type& k, std::string* record) {
+        const auto i = _key_to_location.find(k);
+        if (i == _key_to_location.end()) {
+            return false;
+        }
+        if (record) {
+            read(i->second, *record);
+        }
+        _dead_bytes += i->second.length;
+        _key_tracker.erase(i->second.tracker_iterator);
+        _key_to_location.erase(i);
+        return true;
+    }
+
+    void read(const location& loc, std::string& record) {
+        record.resize(static_cast<size_t>(loc.length));
+        _file.seekg(static_cast<std::streamoff>(loc.offset));
+        _file.read(&record[0], static_cast<std::streamsize>(loc.length));
+        if (!_file) {
+            _file.clear();
+            throw std::runtime_error("Unable to read disk tier file: " + _path);
+        }
+    }
+
+    // Rewrite the file without unused records, if they take
+    // more than half of it; _index_mutex must be held 
+    void compact_if_needed() {
+        if (_dead_bytes * 2 <= _file_size) {
+            return;
+        }
+
+        const std::string compacted_path = _path + ".compact";
+        std::fstream compacted(compacted_path, std::ios::in | std::ios::out | std::ios::binary | std::ios::trunc);
+        if (!compacted) {
+            throw std::runtime_error("Unable to open disk tier file: " + compacted_path);
+        }
+
+        uint64_t offset = 0;
+        std::string record;
+        for (const key_type& k : _key_tracker) {
+            location& loc = _key_to_location.find(k)->second;
+            read(loc, record);
+            compacted.write(record.data(), record.size());
+            loc.offset = offset;
+            offset += loc.length;
+        }
+        compacted.close();
+        _file.close();
+
+        std::remove(_path.c_str());
+        if (std::rename(compacted_path.c_str(), _path.c_str()) != 0) {
+            throw std::runtime_error("Unable to replace disk tier file: " + _path);
+        }
+
+        _file.open(_path, std::ios::in | std::ios::out | std::ios::binary);
+        if (!_file) {
+            throw std::runtime_error("Unable to open disk tier file: " + _path);
+        }
+        _file_size = offset;
+        _dead_bytes = 0;
+    }
+
+    const std::string _path;
+
+    // Maximum number of keys to be retained in the file 
+    const size_t _capacity;
+
+    const serializer_type _serialize;
+    const deserializer_type _deserialize;
+
+    // Number of queued pairs that triggers a write 
+    const size_t _batch_size;
+
+    // Pairs queued for writing, and the batch being written 
+    std::unique_ptr<pending_type> _pending;
+    std::unique_ptr<pending_type> _writing;
+
+    bool _stopping = false;
+
+    // This mutex guards _pending, _writing and _stopping
+    std::mutex _pending_mutex;
+    std::condition_variable _pending_cv;
+
+    // Serializes write_batch() calls
+    std::mutex _write_mutex;
+
+    // The file, and the keys stored there 
+    std::fstream _file;
+    uint64_t _file_size = 0;
+    uint64_t _dead_bytes = 0;
+    key_tracker_type _key_tracker;
+    key_to_location_type _key_to_location;
+
+    // This mutex guards the file and its index
+    mutable std::mutex _index_mutex;
+
+    std::thread _writer;
+};
+
+// Wrap the function to be cached so that keys found in the
+// disk tier are taken from there, instead of evaluating f.
+// To fill the tier, pass the evictions of the cache (removals
+// with removal_cause::size) to put(). If the tier cannot be
+// read, f is evaluated.
+//
+// Values taken from the tier are not evaluated again, so
+// invalidating the cache alone would bring the old values
+// back. Erase keys with erase_with_disk_tier(); likewise,
+// call the tier's erase_if() or clear() both before and after
+// the cache's erase_if() or invalidate_all() and
+// flush_removals(). 
+template <typename K, typename V, template<typename...> class MAP>
+std::function<V(const K&)> with_disk_tier(
+    std::shared_ptr<disk_tier_using_std<K, V, MAP> > tier,
+    std::function<V(const K&)> f
+)
+{
+    return [tier, f](const K& k) {
+        std::unique_ptr<V> v;
+        try {
+            v = tier->take(k);
+        }
+        catch (...) {
+            // A tier that cannot be read is only a miss
+        }
+        if (v) {
+            return *v;
+        }
+        return f(k);
+    };
+}
+
+// Erase k from a cache that uses with_disk_tier(), and from
+// the tier. The tier is erased first, so that an evaluation
+// that takes the old value from it is still in progress when
+// the cache is erased, and does not store the value. It is
+// erased again once the removals of the cache have been
+// delivered, in case the old value was just evicted to the
+// tier. Returns true if the cache had a value for k. 
+template <typename CACHE, typename K, typename V, template<typename...> class MAP>
+bool erase_with_disk_tier(
+    CACHE& cache,
+    disk_tier_using_std<K, V, MAP>& tier,
+    const K& k
+)
+{
+    tier.erase(k);
+    const bool erased = cache.erase(k);
+    cache.flush_removals();
+    tier.erase(k);
+    return erased;
+}
+
+#endif // _disk_tier_using_std_
@@ -0,0 +1,245 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _epoch_reclaimer_ 
+#define _epoch_reclaimer_ 
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <new>
+#include <thread>
+#include <vector>
+
+// Epoch-based reclamation: lets readers use shared objects
+// without locks, while writers unlink and retire them, and
+// defers freeing a retired object until no reader can still
+// hold a pointer to it.
+//
+// Readers pin the current epoch for the duration of a read
+// (using guard). An object retired in epoch e is freed only
+// once the global epoch has reached e + 2; the epoch advances
+// only when every pinned reader has seen the current one, so
+// by then all readers that might have seen the object have
+// finished. Readers never wait for writers; a reader that
+// stays pinned for long only delays freeing.
+//
+// Pinning takes one of a fixed number of slots. If more reads
+// than that are in progress at once, further readers do wait:
+// they spin (yielding) until a slot is free, so the number of
+// slots should exceed the number of reading threads.
+//
+// Retired objects are kept in a number of lists, picked by the
+// retiring thread, so that writers on different threads do not
+// contend for one mutex.
+class epoch_reclaimer
+{
+    struct slot;
+
+public:
+
+    // Constructor specifies the number of reader slots 
+    explicit epoch_reclaimer(size_t slots = 128)
+        : _slot_count(slots)
+        , _slot_storage(new char[slots * sizeof(slot) + cache_line_size - 1])
+        , _slots(align_slots(_slot_storage.get()))
+        , _retired_lists(new retired_list[retired_list_count])
+    {
+        assert(_slot_count != 0);
+        for (size_t i = 0; i < _slot_count; ++i) {
+            new (&_slots[i]) slot;
+            _slots[i].epoch.store(idle, std::memory_order_relaxed);
+        }
+    }
+
+    // Frees everything still retired; no reader may be pinned 
+    ~epoch_reclaimer() {
+        for (size_t i = 0; i < retired_list_count; ++i) {
+            for (const retired_object& r : _retired_lists[i].objects) {
+                r.deleter(r.object);
+            }
+        }
+        for (size_t i = 0; i < _slot_count; ++i) {
+            _slots[i].~slot();
+        }
+    }
+
+    // Pins the current epoch for its lifetime 
+    class guard {
+    public:
+        explicit guard(epoch_reclaimer& reclaimer)
+            : _slot(reclaimer.pin())
+        {}
+
+        ~guard() {
+            _slot.epoch.store(idle, std::memory_order_release);
+        }
+
+    private:
+        guard(const guard&);
+        guard& operator=(const guard&);
+
+        slot& _slot;
+    };
+
+    // Have p deleted once no reader can still be using it; p
+    // must already be unreachable for new readers 
+    template <typename T> void retire(T* p) {
+        retire(p, &delete_object<T>);
+    }
+
+    // Same, but have deleter(p) called instead 
+    void retire(void* p, void (*deleter)(void*)) {
+        retired_list& list = _retired_lists[
+            std::hash<std::thread::id>()(std::this_thread::get_id()) % retired_list_count];
+        {
+            std::lock_guard<std::mutex> lock(list.mutex);
+            const retired_object r = { _epoch.load(std::memory_order_seq_cst), p, deleter };
+            list.objects.push_back(r);
+        }
+        _retired_count.fetch_add(1, std::memory_order_relaxed);
+    }
+
+    // Number of objects retired but not yet freed 
+    size_t retired() const {
+        return _retired_count.load(std::memory_order_relaxed);
+    }
+
+    // Move to the next epoch, unless a reader is still pinned
+    // to an older one; returns the current epoch either way 
+    uint64_t advance() {
+        uint64_t current = _epoch.load(std::memory_order_seq_cst);
+        for (size_t i = 0; i < _slot_count; ++i) {
+            const uint64_t e = _slots[i].epoch.load(std::memory_order_seq_cst);
+            if (e != idle && e != current) {
+                return current;
+            }
+        }
+        if (_epoch.compare_exchange_strong(current, current + 1, std::memory_order_seq_cst)) {
+            return current + 1;
+        }
+        return current;
+    }
+
+    // Free the objects that had been retired two epochs before
+    // the given one, as returned by advance(). Callers that keep
+    // further references to retired objects (for example in
+    // buffers that readers append to) can clear those between
+    // advance() and reclaim() 
+    void reclaim(uint64_t epoch) {
+        std::vector<retired_object> freed;
+        for (size_t i = 0; i < retired_list_count; ++i) {
+            retired_list& list = _retired_lists[i];
+            std::lock_guard<std::mutex> lock(list.mutex);
+
+            // Each list is in epoch order 
+            while (!list.objects.empty() && list.objects.front().epoch + 2 <= epoch) {
+                freed.push_back(list.objects.front());
+                list.objects.pop_front();
+            }
+        }
+        _retired_count.fetch_sub(freed.size(), std::memory_order_relaxed);
+        for (const retired_object& r : freed) {
+            r.deleter(r.object);
+        }
+    }
+
+    // Free whatever can be freed now 
+    void collect() {
+        reclaim(advance());
+    }
+
+private:
+
+    epoch_reclaimer(const epoch_reclaimer&);
+    epoch_reclaimer& operator=(const epoch_reclaimer&);
+
+    static const uint64_t idle = std::numeric_limits<uint64_t>::max();
+
+    static const size_t cache_line_size = 64;
+
+    // Number of lists that retired objects are spread over 
+    static const size_t retired_list_count = 16;
+
+    // The epoch pinned by one reader, or idle; padded to a
+    // cache line, as each is written by a different thread 
+    struct slot {
+        std::atomic<uint64_t> epoch;
+        char padding[cache_line_size - sizeof(std::atomic<uint64_t>)];
+    };
+
+    struct retired_object {
+        uint64_t epoch;
+        void* object;
+        void (*deleter)(void*);
+    };
+
+    struct retired_list {
+        // Oldest first 
+        std::deque<retired_object> objects;
+
+        // This mutex guards objects 
+        std::mutex mutex;
+    };
+
+    template <typename T> static void delete_object(void* p) {
+        delete static_cast<T*>(p);
+    }
+
+    // Operator new does not guarantee more than the alignment
+    // of the fundamental types, so the slots are placed in a
+    // buffer large enough to start them at a cache line 
+    static slot* align_slots(char* storage) {
+        const uintptr_t address = reinterpret_cast<uintptr_t>(storage);
+        const uintptr_t aligned = (address + cache_line_size - 1) & ~uintptr_t(cache_line_size - 1);
+        return reinterpret_cast<slot*>(storage + (aligned - address));
+    }
+
+    // Claim a free slot, starting from one that depends on the
+    // calling thread so that threads do not compete for slots 
+    slot& pin() {
+        size_t i = std::hash<std::thread::id>()(std::this_thread::get_id()) % _slot_count;
+        for (;;) {
+            for (size_t tries = 0; tries < _slot_count; ++tries) {
+                uint64_t expected = idle;
+                if (_slots[i].epoch.compare_exchange_strong(
+                        expected, _epoch.load(std::memory_order_seq_cst), std::memory_order_seq_cst)) {
+                    return _slots[i];
+                }
+                i = (i + 1) % _slot_count;
+            }
+            std::this_thread::yield();
+        }
+    }
+
+    const size_t _slot_count;
+    const std::unique_ptr<char[]> _slot_storage;
+    slot* const _slots;
+
+    std::atomic<uint64_t> _epoch { 0 };
+
+    // Retired objects, spread over a number of lists 
+    const std::unique_ptr<retired_list[]> _retired_lists;
+    std::atomic<size_t> _retired_count { 0 };
+};
+
+#endif // _epoch_reclaimer_
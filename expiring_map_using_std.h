@@ -0,0 +1,173 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _expiring_map_using_std_ 
+#define _expiring_map_using_std_ 
+
+#include <cassert> 
+#include <chrono>
+#include <cstddef>
+#include <list>
+
+// Bounded map whose entries expire a fixed time after they
+// were inserted. When the map is full, the oldest entry is
+// dropped to make space. Because the time-to-live is the
+// same for all entries, insertion order is also expiration
+// order, so a single list serves both purposes.
+// Not thread-safe.
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename T,
+    template<typename...> class MAP
+> class expiring_map_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef T mapped_type;
+    typedef std::chrono::steady_clock clock_type;
+
+    // Keys in insertion order, oldest at front 
+    typedef std::list<key_type> key_tracker_type;
+
+    struct record_type {
+        mapped_type value;
+        clock_type::time_point expires_at;
+        typename key_tracker_type::iterator tracker_iterator;
+    };
+
+    typedef MAP<
+        key_type,
+        record_type
+    > key_to_value_type;
+
+    // Constructor specifies the maximum number of entries
+    // and how long each entry is retained 
+    expiring_map_using_std(
+        size_t c,
+        clock_type::duration ttl
+    )
+        : _capacity(c)
+        , _ttl(ttl)
+    {
+        assert(_capacity != 0);
+    }
+
+    // Return the value stored for k, or nullptr if there is
+    // no such value or it has expired. The returned pointer
+    // is valid until the map is next modified. 
+    const mapped_type* find(const key_type& k, clock_type::time_point now) {
+        purge_expired(now);
+        const auto i = _key_to_value.find(k);
+        if (i == _key_to_value.end()) {
+            return nullptr;
+        }
+        return &i->second.value;
+    }
+
+    // Store a value for k, replacing any previous value
+    // and restarting its time-to-live 
+    void insert(const key_type& k, const mapped_type& v, clock_type::time_point now) {
+        erase(k);
+        purge_expired(now);
+
+        if (_key_to_value.size() == _capacity) {
+            erase_oldest();
+        }
+
+        const typename key_tracker_type::iterator it
+            = _key_tracker.insert(_key_tracker.end(), k);
+
+        const record_type record = { v, now + _ttl, it };
+        _key_to_value.insert(std::make_pair(k, record));
+    }
+
+    // Remove k; returns true if it was present 
+    bool erase(const key_type& k) {
+        const auto i = _key_to_value.find(k);
+        if (i == _key_to_value.end()) {
+            return false;
+        }
+        _key_tracker.erase(i->second.tracker_iterator);
+        _key_to_value.erase(i);
+        return true;
+    }
+
+    // Remove all entries for which
+    //     bool pred(const K&, const T&)
+    // returns true 
+    template <typename PREDICATE>
+    void erase_if(PREDICATE pred) {
+        typename key_tracker_type::iterator src = _key_tracker.begin();
+        while (src != _key_tracker.end()) {
+            const auto i = _key_to_value.find(*src);
+            assert(i != _key_to_value.end());
+            if (pred(i->first, i->second.value)) {
+                src = _key_tracker.erase(src);
+                _key_to_value.erase(i);
+            }
+            else {
+                ++src;
+            }
+        }
+    }
+
+    void clear() {
+        _key_to_value.clear();
+        _key_tracker.clear();
+    }
+
+    size_t size() const {
+        return _key_to_value.size();
+    }
+
+private:
+
+    // Drop entries whose time-to-live has passed 
+    void purge_expired(clock_type::time_point now) {
+        while (!_key_tracker.empty()) {
+            const auto i = _key_to_value.find(_key_tracker.front());
+            assert(i != _key_to_value.end());
+            if (i->second.expires_at > now) {
+                break;
+            }
+            _key_to_value.erase(i);
+            _key_tracker.pop_front();
+        }
+    }
+
+    void erase_oldest() {
+        assert(!_key_tracker.empty());
+        const bool erased = erase(_key_tracker.front());
+        assert(erased);
+        (void)erased;
+    }
+
+    // Maximum number of entries to be retained 
+    const size_t _capacity;
+
+    // How long each entry is retained 
+    const clock_type::duration _ttl;
+
+    // Insertion (and hence expiration) order 
+    key_tracker_type _key_tracker;
+
+    // Key-to-value lookup 
+    key_to_value_type _key_to_value;
+};
+
+#endif // _expiring_map_using_std_
@@ -0,0 +1,41 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _fibonacci_hash_ 
+#define _fibonacci_hash_ 
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+
+// Map hash value h to one of 2^bits slots. The hash is
+// multiplied by 2^64 divided by the golden ratio, and the high
+// bits of the product are kept (Fibonacci hashing), so that
+// identity hashes (as for integers) still spread over all of
+// the slots. 
+inline size_t fibonacci_slot(uint64_t h, unsigned int bits) {
+    assert(bits > 0 && bits < 64);
+    return static_cast<size_t>((h * 0x9E3779B97F4A7C15ull) >> (64 - bits));
+}
+
+// Map the std::hash of k to one of 2^bits slots 
+template <typename K>
+size_t fibonacci_hash(const K& k, unsigned int bits) {
+    return fibonacci_slot(static_cast<uint64_t>(std::hash<K>()(k)), bits);
+}
+
+#endif // _fibonacci_hash_
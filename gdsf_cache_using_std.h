@@ -0,0 +1,244 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _gdsf_cache_using_std_ 
+#define _gdsf_cache_using_std_ 
+
+#include "stopwatch.h"
+#include <algorithm>
+#include <cassert> 
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <functional> // for std::function
+
+// Class providing a cache of a function with signature 
+// V f(K), bounded by the total size of the cached values, 
+// that evicts by GreedyDual-Size-Frequency priority 
+// (Cherkasova, "Improving WWW Proxies Performance with
+// Greedy-Dual-Size-Frequency Caching Policy", 1998):
+//
+//   priority = L + frequency * cost / size
+//
+// where cost is the time it took to evaluate the value (or
+// whatever a user-supplied cost function returns), size is
+// given by a user-supplied size function (1 for every value
+// by default, in which case the capacity is a number of
+// records), and L is the priority of the last evicted record.
+// Raising L ages the records that are not being hit. Cheap
+// and large values thus go first, and the total cost of
+// recomputing evicted values is kept low, rather than their
+// number. 
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class gdsf_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    // Keys by priority, lowest (next to be evicted) first 
+    typedef std::multimap<double, key_type> priority_queue_type;
+
+    // Cached value, and what its priority is made of 
+    struct record_type {
+        value_type value;
+        uint64_t frequency;
+        double cost;
+        size_t size;
+        typename priority_queue_type::iterator priority_iterator;
+    };
+
+    typedef MAP<key_type, record_type> key_to_value_type;
+
+    typedef std::function<value_type(const key_type&)> function_type;
+    typedef std::function<size_t(const key_type&, const value_type&)> size_function_type;
+    typedef std::function<double(const key_type&, const value_type&)> cost_function_type;
+
+    // Constructor specifies the cached function, the maximum 
+    // total size of the values to be stored, and optionally 
+    // functions that give the size and the cost of a value; 
+    // by default, each value has size 1, and the cost is the
+    // evaluation time in seconds 
+    gdsf_cache_using_std(
+        function_type f,
+        size_t c,
+        size_function_type size = size_function_type(),
+        cost_function_type cost = cost_function_type()
+    )
+        : _fn(f)
+        , _capacity(c)
+        , _size_fn(size)
+        , _cost_fn(cost)
+    {
+        assert(_capacity != 0);
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+
+        // Attempt to find existing record 
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+
+        if (it != _key_to_value.end()) {
+
+            // We do have it: raise its priority 
+            record_type& record = (*it).second;
+            ++record.frequency;
+            _priorities.erase(record.priority_iterator);
+            record.priority_iterator = _priorities.insert(std::make_pair(priority(record), k));
+            return record.value;
+        }
+
+        // We don't have it: evaluate function and create
+        // new record 
+        const stopwatch timer;
+        const value_type v = _fn(k);
+        const double cost = _cost_fn ? _cost_fn(k, v) : timer.elapsed_seconds();
+
+        _evaluation_cost += cost;
+        ++_evaluations;
+
+        insert(k, v, cost);
+        return v;
+    }
+
+    // Obtain the cached keys, highest priority at head, next 
+    // eviction candidate at tail. 
+    // This method is provided purely to support testing. 
+    template <typename IT> void get_keys(IT dst) const {
+        typename priority_queue_type::const_reverse_iterator src
+            = _priorities.rbegin();
+        while (src != _priorities.rend()) {
+            *dst++ = (*src++).second;
+        }
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        return _key_to_value.find(k) != _key_to_value.end();
+    }
+
+    // Set a key-value pair that may be missing in the cache;
+    // returns true if the pair was inserted. Without a cost 
+    // function, the cost is taken to be the average cost of
+    // the evaluations so far 
+    bool set(const key_type& k, const value_type& v) {
+        if (has(k)) {
+            return false;
+        }
+        const double cost = _cost_fn
+            ? _cost_fn(k, v)
+            : _evaluations > 0 ? _evaluation_cost / _evaluations : 0.0;
+        insert(k, v, cost);
+        return has(k);
+    }
+
+    // Total size of the cached values 
+    size_t get_size() const {
+        return _size;
+    }
+
+    // Total cost of all evaluations of the cached function so 
+    // far; this is what the eviction policy tries to minimize 
+    double get_evaluation_cost() const {
+        return _evaluation_cost;
+    }
+
+private:
+
+    // Priority of a record, given the current value of L 
+    double priority(const record_type& record) const {
+        return _inflation + record.frequency * record.cost / record.size;
+    }
+
+    // Record a fresh key-value pair in the cache 
+    void insert(const key_type& k, const value_type& v, double cost) {
+
+        // Method is only called on cache misses 
+        assert(_key_to_value.find(k) == _key_to_value.end());
+
+        // Sizes of 0 would make the priority infinite 
+        const size_t size = _size_fn ? std::max<size_t>(_size_fn(k, v), 1) : 1;
+
+        // Values that cannot fit at all are not cached 
+        if (size > _capacity) {
+            return;
+        }
+
+        // Make space if necessary 
+        while (_size + size > _capacity) {
+            evict();
+        }
+
+        record_type record = { v, 1, cost, size, _priorities.end() };
+        record.priority_iterator = _priorities.insert(std::make_pair(priority(record), k));
+        _key_to_value.insert(std::make_pair(k, record));
+        _size += size;
+    }
+
+    // Purge the record with the lowest priority, and age the
+    // others by raising L to its priority 
+    void evict() {
+
+        // Assert method is never called when cache is empty 
+        assert(!_priorities.empty());
+
+        const typename priority_queue_type::iterator lowest = _priorities.begin();
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find((*lowest).second);
+        assert(it != _key_to_value.end());
+
+        _inflation = (*lowest).first;
+        _size -= (*it).second.size;
+
+        _key_to_value.erase(it);
+        _priorities.erase(lowest);
+    }
+
+    // The function to be cached 
+    const function_type _fn;
+
+    // Maximum total size of the values to be retained 
+    const size_t _capacity;
+
+    // Size and cost of a value (may be empty) 
+    const size_function_type _size_fn;
+    const cost_function_type _cost_fn;
+
+    // Total size of the cached values 
+    size_t _size = 0;
+
+    // "L": priority of the last evicted record 
+    double _inflation = 0.0;
+
+    // Total cost and number of evaluations so far 
+    double _evaluation_cost = 0.0;
+    uint64_t _evaluations = 0;
+
+    // Keys by priority 
+    priority_queue_type _priorities;
+
+    // Key-to-value lookup 
+    key_to_value_type _key_to_value;
+};
+
+#endif // _gdsf_cache_using_std_
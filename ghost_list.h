@@ -0,0 +1,108 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _ghost_list_ 
+#define _ghost_list_ 
+
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+// Remembers the last N keys evicted from a cache, by their
+// hashes only, so that memory use is small and fixed whatever
+// the key type. Hash collisions may make a key look recently
+// evicted when it was not; with 64-bit hashes this is rare.
+// Not thread-safe.
+class ghost_list
+{
+public:
+
+    typedef uint64_t hash_type;
+
+    // Constructor specifies the number of evictions to remember 
+    explicit ghost_list(size_t c)
+        : _capacity(c)
+    {
+        assert(_capacity != 0);
+        _ring.reserve(_capacity);
+    }
+
+    // Record the eviction of a key 
+    void add(hash_type h) {
+        ++_evictions;
+
+        if (_ring.size() < _capacity) {
+            _ring.push_back(std::make_pair(h, _evictions));
+        }
+        else {
+            // Forget the oldest eviction, unless its key has
+            // been evicted again since
+            std::pair<hash_type, uint64_t>& oldest = _ring[_next];
+            const auto i = _hash_to_eviction.find(oldest.first);
+            if (i != _hash_to_eviction.end() && i->second == oldest.second) {
+                _hash_to_eviction.erase(i);
+            }
+            oldest = std::make_pair(h, _evictions);
+            _next = (_next + 1) % _capacity;
+        }
+
+        _hash_to_eviction[h] = _evictions;
+    }
+
+    // If the key was among the remembered evictions, forget it
+    // and return how many evictions ago it was evicted (1 for
+    // the most recent eviction); otherwise return 0 
+    uint64_t remove(hash_type h) {
+        const auto i = _hash_to_eviction.find(h);
+        if (i == _hash_to_eviction.end()) {
+            return 0;
+        }
+        const uint64_t distance = _evictions - i->second + 1;
+        _hash_to_eviction.erase(i);
+        return distance;
+    }
+
+    // Number of evictions remembered 
+    size_t capacity() const {
+        return _capacity;
+    }
+
+    void clear() {
+        _ring.clear();
+        _next = 0;
+        _hash_to_eviction.clear();
+    }
+
+private:
+
+    // Maximum number of evictions to remember 
+    const size_t _capacity;
+
+    // Total number of evictions so far 
+    uint64_t _evictions = 0;
+
+    // Remembered evictions, oldest at _next once full 
+    std::vector<std::pair<hash_type, uint64_t> > _ring;
+    size_t _next = 0;
+
+    // Latest eviction of each remembered key 
+    std::unordered_map<hash_type, uint64_t> _hash_to_eviction;
+};
+
+#endif // _ghost_list_
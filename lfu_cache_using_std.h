@@ -0,0 +1,268 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _lfu_cache_using_std_ 
+#define _lfu_cache_using_std_ 
+
+#include <cassert> 
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <list>
+#include <functional> // for std::function
+
+// Class providing fixed-size (by number of records) 
+// LFU-replacement cache of a function with signature 
+// V f(K), with the same interface as lru_cache_using_std. 
+//
+// Records are kept in a list of frequency buckets in
+// increasing order of access count, each bucket holding its
+// keys in LRU order, so that a hit, an insertion and an
+// eviction all take constant time (Shah, Mitra & Matani,
+// "An O(1) algorithm for implementing the LFU cache eviction
+// scheme", 2010). Ties are broken by evicting the least
+// recently used key.
+//
+// Optionally, all frequencies are halved after a given number 
+// of accesses, so that keys that were popular once do not stay
+// in the cache forever. 
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class lfu_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    // Keys with the same access count, most recent at back 
+    struct bucket_type {
+        uint64_t frequency;
+        std::list<key_type> keys;
+    };
+
+    // Buckets in increasing order of frequency 
+    typedef std::list<bucket_type> bucket_list_type;
+
+    // Cached value, and where its key is 
+    struct record_type {
+        value_type value;
+        typename bucket_list_type::iterator bucket;
+        typename std::list<key_type>::iterator tracker_iterator;
+    };
+
+    typedef MAP<key_type, record_type> key_to_value_type;
+
+    typedef std::function<value_type(const key_type&)> function_type;
+
+    // Constructor specifies the cached function, the maximum 
+    // number of records to be stored, and the number of accesses
+    // after which frequencies are halved (0 to never age them) 
+    lfu_cache_using_std(
+        function_type f,
+        size_t c,
+        uint64_t aging_period = 0
+    )
+        : _fn(f)
+        , _capacity(c)
+        , _aging_period(aging_period)
+    {
+        assert(_capacity != 0);
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+
+        age();
+
+        // Attempt to find existing record 
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+
+        if (it != _key_to_value.end()) {
+
+            // We do have it: move it to the next bucket 
+            record_type& record = (*it).second;
+            increment(record);
+            return record.value;
+        }
+
+        // We don't have it: evaluate function and create
+        // new record 
+        const value_type v = _fn(k);
+        insert(k, v);
+        return v;
+    }
+
+    // Obtain the cached keys, most frequently (and then most
+    // recently) used element at head, next eviction candidate
+    // at tail. 
+    // This method is provided purely to support testing. 
+    template <typename IT> void get_keys(IT dst) const {
+        typename bucket_list_type::const_reverse_iterator bucket
+            = _buckets.rbegin();
+        while (bucket != _buckets.rend()) {
+            typename std::list<key_type>::const_reverse_iterator src
+                = (*bucket).keys.rbegin();
+            while (src != (*bucket).keys.rend()) {
+                *dst++ = *src++;
+            }
+            ++bucket;
+        }
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        return _key_to_value.find(k) != _key_to_value.end();
+    }
+
+    // Set a key-value pair that may be missing in the cache;
+    // returns true if the pair was inserted
+    bool set(const key_type& k, const value_type& v) {
+        if (has(k)) {
+            return false;
+        }
+        insert(k, v);
+        return true;
+    }
+
+    // Access count of a cached key (0 if not cached) 
+    uint64_t get_frequency(const key_type& k) const {
+        const typename key_to_value_type::const_iterator it
+            = _key_to_value.find(k);
+        return it == _key_to_value.end() ? 0 : (*(*it).second.bucket).frequency;
+    }
+
+private:
+
+    // Record a fresh key-value pair in the cache 
+    void insert(const key_type& k, const value_type& v) {
+
+        // Method is only called on cache misses 
+        assert(_key_to_value.find(k) == _key_to_value.end());
+
+        // Make space if necessary 
+        if (_key_to_value.size() == _capacity) {
+            evict();
+        }
+
+        if (_buckets.empty() || _buckets.front().frequency != 1) {
+            const bucket_type bucket = { 1, std::list<key_type>() };
+            _buckets.push_front(bucket);
+        }
+
+        const typename bucket_list_type::iterator bucket = _buckets.begin();
+        const typename std::list<key_type>::iterator it
+            = (*bucket).keys.insert((*bucket).keys.end(), k);
+        const record_type record = { v, bucket, it };
+        _key_to_value.insert(std::make_pair(k, record));
+    }
+
+    // Move a record to the back of the bucket for its
+    // frequency plus one 
+    void increment(record_type& record) {
+        const typename bucket_list_type::iterator bucket = record.bucket;
+        typename bucket_list_type::iterator next = std::next(bucket);
+
+        if (next == _buckets.end() || (*next).frequency != (*bucket).frequency + 1) {
+            const bucket_type new_bucket = { (*bucket).frequency + 1, std::list<key_type>() };
+            next = _buckets.insert(next, new_bucket);
+        }
+
+        (*next).keys.splice((*next).keys.end(), (*bucket).keys, record.tracker_iterator);
+        record.bucket = next;
+
+        if ((*bucket).keys.empty()) {
+            _buckets.erase(bucket);
+        }
+    }
+
+    // Purge the least-recently-used element of the 
+    // least-frequently-used bucket 
+    void evict() {
+
+        // Assert method is never called when cache is empty 
+        assert(!_buckets.empty());
+
+        bucket_type& bucket = _buckets.front();
+        assert(!bucket.keys.empty());
+
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(bucket.keys.front());
+        assert(it != _key_to_value.end());
+
+        _key_to_value.erase(it);
+        bucket.keys.pop_front();
+
+        if (bucket.keys.empty()) {
+            _buckets.pop_front();
+        }
+    }
+
+    // Halve all frequencies once per aging period; this is
+    // linear in the number of records, but happens rarely
+    // enough to be constant time amortized (as long as the
+    // period is not shorter than the capacity) 
+    void age() {
+        if (_aging_period == 0 || ++_accesses_since_aging < _aging_period) {
+            return;
+        }
+        _accesses_since_aging = 0;
+
+        // Halving keeps the buckets in order, but adjacent
+        // buckets may end up with the same frequency 
+        typename bucket_list_type::iterator bucket = _buckets.begin();
+        while (bucket != _buckets.end()) {
+            const uint64_t frequency = (*bucket).frequency > 1 ? (*bucket).frequency / 2 : 1;
+
+            if (bucket != _buckets.begin() && (*std::prev(bucket)).frequency == frequency) {
+                const typename bucket_list_type::iterator previous = std::prev(bucket);
+                for (const key_type& k : (*bucket).keys) {
+                    (*_key_to_value.find(k)).second.bucket = previous;
+                }
+                (*previous).keys.splice((*previous).keys.end(), (*bucket).keys);
+                bucket = _buckets.erase(bucket);
+            }
+            else {
+                (*bucket).frequency = frequency;
+                ++bucket;
+            }
+        }
+    }
+
+    // The function to be cached 
+    const function_type _fn;
+
+    // Maximum number of key-value pairs to be retained 
+    const size_t _capacity;
+
+    // Accesses between halvings of the frequencies (0 = never) 
+    const uint64_t _aging_period;
+
+    // Accesses since the frequencies were last halved 
+    uint64_t _accesses_since_aging = 0;
+
+    // Frequency buckets, least frequently used at front 
+    bucket_list_type _buckets;
+
+    // Key-to-value lookup 
+    key_to_value_type _key_to_value;
+};
+
+#endif // _lfu_cache_using_std_
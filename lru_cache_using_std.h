@@ -17,9 +17,17 @@
 #ifndef _lru_cache_using_std_ 
 #define _lru_cache_using_std_ 
 
+#include "ghost_list.h"
+#include <algorithm>
 #include <cassert> 
+#include <cstddef>
+#include <cstdint>
 #include <list>
+#include <random>
 #include <functional> // for std::function
+#include <iosfwd>
+#include <vector>
+#include <memory>
 
 // Class providing fixed-size (by number of records) 
 // LRU-replacement cache of a function with signature 
@@ -43,17 +51,50 @@ public:
     // Key access history, most recent at back 
     typedef std::list<key_type> key_tracker_type;
 
+    // Cached value, its key history iterator, the promotion
+    // tick at which the key was last moved to the back of the
+    // history, and the time in seconds that it took to evaluate
+    // the value (0 if not known) 
+    struct record_type {
+        value_type value;
+        typename key_tracker_type::iterator tracker_iterator;
+        size_t promoted_at;
+        double cost;
+    };
+
     // Key to value and key history iterator 
     typedef MAP<
         key_type,
-        std::pair<
-        value_type,
-        typename key_tracker_type::iterator
-        >
+        record_type
     > key_to_value_type;
 
     typedef std::function<value_type(const key_type&)> function_type;
 
+    // Why a key-value pair was removed from the cache 
+    enum class removal_cause {
+        size,               // evicted to make space
+        replaced,           // the key was given a new value
+        explicit_removal    // erased or invalidated by the user
+    };
+
+    // Called with each key-value pair removed from the cache 
+    typedef std::function<void(const key_type&, const value_type&, removal_cause)> removal_callback_type;
+
+    // Controls how cache hits update the key access history.
+    // The defaults give plain LRU: every hit moves the key to
+    // the back of the list. Skipping some of these moves trades
+    // a little hit ratio for far fewer writes to list nodes.
+    struct promotion_policy {
+        // A hit is not promoted if the key has been promoted
+        // (or inserted) within the last recent_fraction * capacity
+        // promotions, which guarantees that it is already within
+        // that many most recently used keys
+        double recent_fraction = 0.0;
+
+        // Other hits are promoted with this probability
+        double probability = 1.0;
+    };
+
     // Constructor specifies the cached function and 
     // the maximum number of records to be stored 
     lru_cache_using_std(
@@ -64,6 +105,89 @@ public:
         , _capacity(c)
     {
         assert(_capacity != 0);
+        set_promotion_policy(promotion_policy());
+    }
+
+    // Counts of values added to the cache, and of those added
+    // for keys that had been evicted not long before 
+    struct recompute_stats {
+        size_t evaluations = 0;
+        size_t recomputations = 0;
+    };
+
+    // Start counting how often keys are evaluated again after
+    // having been evicted; a high rate means that the cache is
+    // too small. The last ghost_capacity evicted keys are
+    // remembered, by hash only, so the cost is small and
+    // bounded. Values added with set() or load() count as
+    // evaluations, too.
+    template <typename HASH = std::hash<key_type> >
+    void enable_recompute_tracking(size_t ghost_capacity, HASH hash = HASH()) {
+        _ghosts.reset(new ghost_list(ghost_capacity));
+        _ghost_hash = hash;
+        _recompute_stats = recompute_stats();
+
+        const size_t max_buckets = 32;
+        _recomputations_by_distance.assign(std::min(ghost_capacity, max_buckets), 0);
+    }
+
+    void disable_recompute_tracking() {
+        _ghosts.reset();
+        _ghost_hash = nullptr;
+        _recomputations_by_distance.clear();
+    }
+
+    recompute_stats get_recompute_stats() const {
+        return _recompute_stats;
+    }
+
+    // A point on the curve returned by get_capacity_curve() 
+    struct capacity_curve_point {
+        size_t capacity;
+        size_t additional_hits;
+    };
+
+    // Estimate how many more hits there would have been with
+    // a larger capacity (up to the current capacity plus the
+    // ghost capacity), since recompute tracking was enabled.
+    // A recomputed key that was evicted d evictions earlier
+    // would have stayed in a cache with d more slots. Divide
+    // by get_recompute_stats().evaluations (plus the hits) to
+    // get hit ratios.
+    std::vector<capacity_curve_point> get_capacity_curve() const {
+        std::vector<capacity_curve_point> curve;
+        if (!_ghosts) {
+            return curve;
+        }
+        const size_t buckets = _recomputations_by_distance.size();
+        size_t additional_hits = 0;
+        for (size_t b = 0; b < buckets; ++b) {
+            additional_hits += _recomputations_by_distance[b];
+            const capacity_curve_point point = {
+                _capacity + ((b + 1) * _ghosts->capacity() + buckets - 1) / buckets,
+                additional_hits
+            };
+            curve.push_back(point);
+        }
+        return curve;
+    }
+
+    // Change the way hits update the access history
+    void set_promotion_policy(const promotion_policy& p) {
+        assert(p.recent_fraction >= 0.0 && p.recent_fraction <= 1.0);
+        assert(p.probability >= 0.0 && p.probability <= 1.0);
+
+        _promotion_window = static_cast<size_t>(p.recent_fraction * _capacity);
+
+        const double rng_range = static_cast<double>(_rng.max() - _rng.min()) + 1.0;
+        _promotion_is_random = p.probability < 1.0;
+        _promotion_threshold = static_cast<std::uint_fast32_t>(p.probability * rng_range);
+    }
+
+    // Register a function to be called, just before removal,
+    // for each removed key-value pair 
+    void set_removal_callback(removal_callback_type f) {
+        _on_remove = f;
     }
 
     // Obtain value of the cached function for k 
@@ -79,7 +203,7 @@ public:
 
             // Evaluate function and create new record 
             const value_type v = _fn(k);
-            insert(k, v);
+            insert(k, v, 0.0);
 
 #ifndef NDEBUG
             // Update evaluation counters
@@ -103,17 +227,21 @@ public:
         else {
 
             // We do have it: 
-
-            // Update access record by moving 
-            // accessed key to back of list 
-            _key_tracker.splice(
-                _key_tracker.end(),
-                _key_tracker,
-                (*it).second.second
-            );
+            record_type& record = (*it).second;
+
+            if (should_promote(record)) {
+                // Update access record by moving 
+                // accessed key to back of list 
+                _key_tracker.splice(
+                    _key_tracker.end(),
+                    _key_tracker,
+                    record.tracker_iterator
+                );
+                record.promoted_at = ++_promotion_tick;
+            }
 
             // Return the retrieved value 
-            return (*it).second.first;
+            return record.value;
         }
     }
 
@@ -128,6 +256,89 @@ public:
         }
     }
 
+    // Write the contents of the cache to os, least recently
+    // used first, so that load() restores the same order.
+    // Each key-value pair is written by calling
+    //     void serialize(std::ostream&, const K&, const V&)
+    template <typename SERIALIZER>
+    void save(std::ostream& os, SERIALIZER serialize) const {
+        for (const key_type& k : _key_tracker) {
+            const typename key_to_value_type::const_iterator it
+                = _key_to_value.find(k);
+            assert(it != _key_to_value.end());
+            serialize(os, k, (*it).second.value);
+        }
+    }
+
+    // Read key-value pairs written by save(), one at a time,
+    // by calling
+    //     bool deserialize(std::istream&, K&, V&)
+    // until it returns false. Each pair becomes the most
+    // recently used one (replacing any existing value), so the
+    // saved order is preserved, and if there are more pairs
+    // than the capacity, the least recently used ones are
+    // evicted as usual. K and V must be default-constructible.
+    // Returns the number of pairs read.
+    template <typename DESERIALIZER>
+    size_t load(std::istream& is, DESERIALIZER deserialize) {
+        size_t count = 0;
+        key_type k;
+        value_type v;
+        while (deserialize(is, k, v)) {
+            assign(k, v);
+            ++count;
+        }
+        return count;
+    }
+
+    // Remove k from the cache; returns true if it was present 
+    bool erase(const key_type& k) {
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+        if (it == _key_to_value.end()) {
+            return false;
+        }
+        remove(it, removal_cause::explicit_removal);
+        return true;
+    }
+
+    // Remove all key-value pairs for which
+    //     bool pred(const K&, const V&)
+    // returns true; returns the number of pairs removed 
+    template <typename PREDICATE>
+    size_t erase_if(PREDICATE pred) {
+        size_t count = 0;
+        typename key_tracker_type::iterator src = _key_tracker.begin();
+        while (src != _key_tracker.end()) {
+            const typename key_to_value_type::iterator it
+                = _key_to_value.find(*src++);
+            assert(it != _key_to_value.end());
+            if (pred((*it).first, (*it).second.value)) {
+                remove(it, removal_cause::explicit_removal);
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Remove all key-value pairs, notifying the removal
+    // callback of each of them 
+    void invalidate_all() {
+        while (!_key_tracker.empty()) {
+            const typename key_to_value_type::iterator it
+                = _key_to_value.find(_key_tracker.front());
+            assert(it != _key_to_value.end());
+            remove(it, removal_cause::explicit_removal);
+        }
+    }
+
+    // Remove all key-value pairs at once, without notifying
+    // the removal callback 
+    void clear() {
+        _key_to_value.clear();
+        _key_tracker.clear();
+    }
+
     // Using the functions has() and set(), it is possible to
     // build a thread-safe cache without having to lock the
     // whole cache in order to evaluate (and keep) a new value.
@@ -137,11 +348,14 @@ public:
         return _key_to_value.find(k) != _key_to_value.end();
     }
 
-    // Set a key-value pair that may be missing in the cache
-    void set(const key_type& k, const value_type& v) {
+    // Set a key-value pair that may be missing in the cache,
+    // along with the time in seconds that it took to evaluate
+    // the value, if known; returns true if the pair was inserted
+    bool set(const key_type& k, const value_type& v, double cost = 0.0) {
         const auto i = _key_to_value.find(k);
         if (i == _key_to_value.end()) {
-            insert(k, v);
+            insert(k, v, cost);
+            return true;
         }
         else {
             // If we already have a value, it would be logical
@@ -155,17 +369,73 @@ public:
             // that the value type has an equality operator.
             // TODO: Use SFINAE to enable the assertion when
             // the value type does have an equality operator.
+            return false;
         }
     }
 
+    // Time in seconds that it took to evaluate the value of k,
+    // as given to set(), if k is in the cache; 0 otherwise.
+    // Values evaluated by operator() are not timed. 
+    double get_cost(const key_type& k) const {
+        const auto i = _key_to_value.find(k);
+        return i == _key_to_value.end() ? 0.0 : i->second.cost;
+    }
+
 private:
 
+    // Decide whether a hit on the given record should move
+    // the key to the back of the access history 
+    bool should_promote(const record_type& record) {
+        // Keys promoted since this one are the only ones that
+        // can be ahead of it in the history 
+        if (_promotion_tick - record.promoted_at < _promotion_window) {
+            return false;
+        }
+        if (_promotion_is_random) {
+            return _rng() - _rng.min() < _promotion_threshold;
+        }
+        return true;
+    }
+
+    // Set the value for k, and make it the most recently used key 
+    void assign(const key_type& k, const value_type& v) {
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+        if (it == _key_to_value.end()) {
+            insert(k, v, 0.0);
+            return;
+        }
+        record_type& record = (*it).second;
+        if (_on_remove) {
+            _on_remove(k, record.value, removal_cause::replaced);
+        }
+        record.value = v;
+        record.cost = 0.0;
+        _key_tracker.splice(
+            _key_tracker.end(),
+            _key_tracker,
+            record.tracker_iterator
+        );
+        record.promoted_at = ++_promotion_tick;
+    }
+
     // Record a fresh key-value pair in the cache 
-    void insert(const key_type& k, const value_type& v) {
+    void insert(const key_type& k, const value_type& v, double cost) {
 
         // Method is only called on cache misses 
         assert(_key_to_value.find(k) == _key_to_value.end());
 
+        if (_ghosts) {
+            ++_recompute_stats.evaluations;
+            const uint64_t distance = _ghosts->remove(_ghost_hash(k));
+            if (distance != 0) {
+                ++_recompute_stats.recomputations;
+                const size_t bucket = static_cast<size_t>(
+                    (distance - 1) * _recomputations_by_distance.size() / _ghosts->capacity());
+                ++_recomputations_by_distance[bucket];
+            }
+        }
+
         // Make space if necessary 
         if (_key_to_value.size() == _capacity)
             evict();
@@ -176,10 +446,11 @@ private:
 
         // Create the key-value entry, 
         // linked to the usage record. 
+        const record_type record = { v, it, ++_promotion_tick, cost };
         _key_to_value.insert(
             std::make_pair(
                 k,
-                std::make_pair(v, it)
+                record
             )
         );
         // No need to check return, 
@@ -197,9 +468,22 @@ private:
             = _key_to_value.find(_key_tracker.front());
         assert(it != _key_to_value.end());
 
+        if (_ghosts) {
+            _ghosts->add(_ghost_hash((*it).first));
+        }
+
+        remove(it, removal_cause::size);
+    }
+
+    // Purge a record, notifying the removal callback first 
+    void remove(typename key_to_value_type::iterator it, removal_cause cause) {
+        if (_on_remove) {
+            _on_remove((*it).first, (*it).second.value, cause);
+        }
+
         // Erase both elements to completely purge record 
+        _key_tracker.erase((*it).second.tracker_iterator);
         _key_to_value.erase(it);
-        _key_tracker.pop_front();
     }
 
     // The function to be cached 
@@ -208,12 +492,39 @@ private:
     // Maximum number of key-value pairs to be retained 
     const size_t _capacity;
 
+    // Optional notification of removals 
+    removal_callback_type _on_remove;
+
     // Key access history 
     key_tracker_type _key_tracker;
 
     // Key-to-value lookup 
     key_to_value_type _key_to_value;
 
+    // Recently evicted keys, if recompute tracking is enabled 
+    std::unique_ptr<ghost_list> _ghosts;
+    std::function<ghost_list::hash_type(const key_type&)> _ghost_hash;
+    recompute_stats _recompute_stats;
+
+    // Recomputations, bucketed by the number of evictions
+    // between the eviction and the recomputation 
+    std::vector<size_t> _recomputations_by_distance;
+
+    // Incremented whenever a key is moved to (or inserted at)
+    // the back of the access history 
+    size_t _promotion_tick = 0;
+
+    // See promotion_policy::recent_fraction 
+    size_t _promotion_window = 0;
+
+    // If set, hits are promoted only if a random draw
+    // falls below the threshold 
+    bool _promotion_is_random = false;
+    std::uint_fast32_t _promotion_threshold = 0;
+
+    // Source of randomness for probabilistic promotion 
+    std::minstd_rand _rng;
+
 #ifndef NDEBUG
     // Evaluation counters
     MAP<key_type, size_t> _eval_counters;
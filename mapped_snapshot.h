@@ -0,0 +1,375 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _mapped_snapshot_ 
+#define _mapped_snapshot_ 
+
+#include <algorithm>
+#include <atomic>
+#include <cassert>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+// Read-only, memory-mapped snapshot of the contents of a cache
+// whose key and value types are trivially copyable (and whose
+// keys have no padding bytes, as keys are compared bytewise).
+// Opening a snapshot only maps the file, so lookups can be
+// served immediately, however large the snapshot is. The file
+// is never modified, but records can be erased from the
+// object, so that its values can be invalidated along with
+// those of the cache.
+//
+// File layout (native byte order and struct layout, so a
+// snapshot is only valid on the platform that wrote it):
+//     header_type
+//     header_type::count times record_type, sorted by key bytes
+template <
+    typename K,
+    typename V
+> class mapped_snapshot
+{
+public:
+
+    static_assert(std::is_trivially_copyable<K>::value, "K must be trivially copyable");
+    static_assert(std::is_trivially_copyable<V>::value, "V must be trivially copyable");
+
+    typedef K key_type;
+    typedef V value_type;
+
+    struct record_type {
+        key_type key;
+        value_type value;
+    };
+
+    struct header_type {
+        char magic[8];
+        uint32_t version;
+        uint32_t key_size;
+        uint32_t value_size;
+        uint32_t record_size;
+        uint64_t count;
+    };
+
+    static const uint32_t current_version = 1;
+
+    // Map the snapshot file at path; throws std::runtime_error
+    // if it cannot be mapped, or was not written for K and V 
+    explicit mapped_snapshot(const std::string& path)
+        : _data(nullptr)
+        , _size(0)
+    {
+        map(path);
+
+        if (_size < sizeof(header_type)) {
+            unmap();
+            throw std::runtime_error("Snapshot file is truncated: " + path);
+        }
+
+        const header_type& header = *static_cast<const header_type*>(_data);
+        if (std::memcmp(header.magic, magic(), sizeof(header.magic)) != 0
+            || header.version != current_version
+            || header.key_size != sizeof(key_type)
+            || header.value_size != sizeof(value_type)
+            || header.record_size != sizeof(record_type)
+            || header.count > (_size - sizeof(header_type)) / sizeof(record_type)) {
+            unmap();
+            throw std::runtime_error("Snapshot file is not compatible: " + path);
+        }
+
+        _records = reinterpret_cast<const record_type*>(static_cast<const char*>(_data) + sizeof(header_type));
+        _count = static_cast<size_t>(header.count);
+    }
+
+    ~mapped_snapshot() {
+        unmap();
+    }
+
+    // Find the value stored for k, unless erased; the returned
+    // pointer remains valid as long as the snapshot object exists 
+    const value_type* find(const key_type& k) const {
+        const record_type* i = find_record(k);
+        if (!i || is_erased(i - _records)) {
+            return nullptr;
+        }
+        return &i->value;
+    }
+
+    // Number of records in the file, including erased ones 
+    size_t size() const {
+        return _count;
+    }
+
+    // Make find() no longer return the value stored for k;
+    // returns true if it did 
+    bool erase(const key_type& k) {
+        const record_type* i = find_record(k);
+        if (!i) {
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(_erased_mutex);
+        return mark_erased(i - _records);
+    }
+
+    // Same for all records for which
+    //     bool pred(const K&, const V&)
+    // returns true; returns the number of records erased 
+    template <typename PREDICATE>
+    size_t erase_if(PREDICATE pred) {
+        size_t count = 0;
+        std::lock_guard<std::mutex> guard(_erased_mutex);
+        for (size_t i = 0; i < _count; ++i) {
+            if (pred(_records[i].key, _records[i].value) && mark_erased(i)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // Same for all records 
+    void clear() {
+        std::lock_guard<std::mutex> guard(_erased_mutex);
+        _erased.assign(_count, true);
+        _has_erased.store(true, std::memory_order_release);
+    }
+
+    // Write the contents of cache (anything with the save()
+    // function of lru_cache_using_std) to a snapshot file at path 
+    template <typename CACHE>
+    static void write(const std::string& path, const CACHE& cache) {
+        std::vector<record_type> records;
+        std::ostream unused(nullptr);
+        cache.save(unused, [&records](std::ostream&, const key_type& k, const value_type& v) {
+            record_type r;
+            std::memset(&r, 0, sizeof(r)); // make padding deterministic
+            r.key = k;
+            r.value = v;
+            records.push_back(r);
+        });
+
+        std::sort(records.begin(), records.end(),
+            [](const record_type& a, const record_type& b) {
+                return std::memcmp(&a.key, &b.key, sizeof(key_type)) < 0;
+            }
+        );
+
+        header_type header;
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, magic(), sizeof(header.magic));
+        header.version = current_version;
+        header.key_size = sizeof(key_type);
+        header.value_size = sizeof(value_type);
+        header.record_size = sizeof(record_type);
+        header.count = records.size();
+
+        std::ofstream out(path, std::ios::binary | std::ios::trunc);
+        out.write(reinterpret_cast<const char*>(&header), sizeof(header));
+        if (!records.empty()) {
+            out.write(reinterpret_cast<const char*>(records.data()), records.size() * sizeof(record_type));
+        }
+        out.close();
+        if (!out) {
+            throw std::runtime_error("Unable to write snapshot file: " + path);
+        }
+    }
+
+private:
+
+    static_assert(sizeof(header_type) % alignof(record_type) == 0, "Records would be misaligned");
+
+    mapped_snapshot(const mapped_snapshot&);
+    mapped_snapshot& operator=(const mapped_snapshot&);
+
+    static const char* magic() {
+        return "LRUSNAP";
+    }
+
+    const record_type* find_record(const key_type& k) const {
+        const record_type* end = _records + _count;
+        const record_type* i = std::lower_bound(_records, end, k,
+            [](const record_type& r, const key_type& k) {
+                return std::memcmp(&r.key, &k, sizeof(key_type)) < 0;
+            }
+        );
+        if (i == end || std::memcmp(&i->key, &k, sizeof(key_type)) != 0) {
+            return nullptr;
+        }
+        return i;
+    }
+
+    bool is_erased(size_t i) const {
+        if (!_has_erased.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(_erased_mutex);
+        return _erased[i];
+    }
+
+    // Erase record i; _erased_mutex must be held 
+    bool mark_erased(size_t i) {
+        if (_erased.empty()) {
+            // Allocated only when first needed, so that opening
+            // a snapshot stays cheap
+            _erased.assign(_count, false);
+            _has_erased.store(true, std::memory_order_release);
+        }
+        if (_erased[i]) {
+            return false;
+        }
+        _erased[i] = true;
+        return true;
+    }
+
+#ifdef _WIN32
+    void map(const std::string& path) {
+        _file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (_file == INVALID_HANDLE_VALUE) {
+            throw std::runtime_error("Unable to open snapshot file: " + path);
+        }
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(_file, &size) || size.QuadPart == 0) {
+            CloseHandle(_file);
+            throw std::runtime_error("Unable to map snapshot file: " + path);
+        }
+        _mapping = CreateFileMappingA(_file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        _data = _mapping ? MapViewOfFile(_mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+        if (!_data) {
+            if (_mapping) {
+                CloseHandle(_mapping);
+            }
+            CloseHandle(_file);
+            throw std::runtime_error("Unable to map snapshot file: " + path);
+        }
+        _size = static_cast<size_t>(size.QuadPart);
+    }
+
+    void unmap() {
+        if (_data) {
+            UnmapViewOfFile(_data);
+            CloseHandle(_mapping);
+            CloseHandle(_file);
+            _data = nullptr;
+        }
+    }
+
+    HANDLE _file;
+    HANDLE _mapping;
+#else
+    void map(const std::string& path) {
+        const int fd = ::open(path.c_str(), O_RDONLY);
+        if (fd < 0) {
+            throw std::runtime_error("Unable to open snapshot file: " + path);
+        }
+        struct stat st;
+        if (::fstat(fd, &st) != 0 || st.st_size == 0) {
+            ::close(fd);
+            throw std::runtime_error("Unable to map snapshot file: " + path);
+        }
+        void* data = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_SHARED, fd, 0);
+        ::close(fd); // the mapping keeps the file open
+        if (data == MAP_FAILED) {
+            throw std::runtime_error("Unable to map snapshot file: " + path);
+        }
+        _data = data;
+        _size = static_cast<size_t>(st.st_size);
+    }
+
+    void unmap() {
+        if (_data) {
+            ::munmap(_data, _size);
+            _data = nullptr;
+        }
+    }
+#endif
+
+    // The mapped file 
+    void* _data;
+    size_t _size;
+
+    // The records within the mapped file 
+    const record_type* _records = nullptr;
+    size_t _count = 0;
+
+    // Records erased from the object, if any; allocated by the
+    // first erase 
+    std::vector<bool> _erased;
+    std::atomic<bool> _has_erased { false };
+
+    // This mutex guards _erased
+    mutable std::mutex _erased_mutex;
+};
+
+// Wrap the function to be cached so that keys found in the
+// snapshot are answered from it, instead of evaluating f.
+// Pass the result to the constructor of a cache: the cache
+// then keeps snapshot values as usual, so that entries are
+// promoted into the live cache on first access.
+//
+// Values found in the snapshot are not evaluated again, so
+// invalidating the cache alone would bring the old values
+// back. Erase keys with erase_with_mapped_snapshot(); likewise,
+// call the snapshot's erase_if() or clear() before the cache's
+// erase_if() or invalidate_all().
+template <typename K, typename V>
+std::function<V(const K&)> with_mapped_snapshot(
+    std::shared_ptr<const mapped_snapshot<K, V> > snapshot,
+    std::function<V(const K&)> f
+)
+{
+    return [snapshot, f](const K& k) {
+        if (const V* v = snapshot->find(k)) {
+            return *v;
+        }
+        return f(k);
+    };
+}
+
+// Erase k from a cache that uses with_mapped_snapshot(), and
+// from the snapshot. The snapshot is erased first, so that an
+// evaluation that reads the old value from it is still in
+// progress when the cache is erased, and does not store the
+// value. Returns true if the cache had a value for k. 
+template <typename CACHE, typename K, typename V>
+bool erase_with_mapped_snapshot(
+    CACHE& cache,
+    mapped_snapshot<K, V>& snapshot,
+    const K& k
+)
+{
+    snapshot.erase(k);
+    return cache.erase(k);
+}
+
+#endif // _mapped_snapshot_
@@ -0,0 +1,342 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _numa_lru_cache_using_std_ 
+#define _numa_lru_cache_using_std_ 
+
+#include "shared_lru_cache_using_std.h"
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+#if defined(_WIN32)
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+#elif defined(__linux__)
+#include <fstream>
+#include <sched.h>
+#include <sstream>
+#endif
+
+// Finds out the number of NUMA nodes, and which node the
+// calling thread is running on. On Linux, the nodes are read
+// from sysfs; on Windows, they are queried from the system.
+// Elsewhere, or if that fails, there is a single node. 
+class numa_topology
+{
+public:
+
+    numa_topology() {
+#if defined(_WIN32)
+        ULONG highest_node = 0;
+        if (GetNumaHighestNodeNumber(&highest_node)) {
+            _node_count = static_cast<size_t>(highest_node) + 1;
+        }
+#elif defined(__linux__)
+        // Node numbers need not be contiguous, so they are
+        // renumbered from 0 here 
+        const std::vector<size_t> nodes = read_list("/sys/devices/system/node/online");
+        for (size_t i = 0; i < nodes.size(); ++i) {
+            std::ostringstream path;
+            path << "/sys/devices/system/node/node" << nodes[i] << "/cpulist";
+            for (size_t cpu : read_list(path.str())) {
+                if (cpu >= _node_of_cpu.size()) {
+                    _node_of_cpu.resize(cpu + 1, 0);
+                }
+                _node_of_cpu[cpu] = i;
+            }
+        }
+        if (!_node_of_cpu.empty()) {
+            _node_count = nodes.size();
+        }
+#endif
+    }
+
+    size_t node_count() const {
+        return _node_count;
+    }
+
+    // The node of the processor that the calling thread is
+    // running on; the thread may of course be moved at any time 
+    size_t current_node() const {
+        if (_node_count == 1) {
+            return 0;
+        }
+#if defined(_WIN32)
+        PROCESSOR_NUMBER processor;
+        GetCurrentProcessorNumberEx(&processor);
+        USHORT node = 0;
+        if (!GetNumaProcessorNodeEx(&processor, &node) || node >= _node_count) {
+            return 0;
+        }
+        return node;
+#elif defined(__linux__)
+        const int cpu = sched_getcpu();
+        if (cpu < 0 || static_cast<size_t>(cpu) >= _node_of_cpu.size()) {
+            return 0;
+        }
+        return _node_of_cpu[cpu];
+#else
+        return 0;
+#endif
+    }
+
+private:
+
+#if defined(__linux__)
+    // Read a sysfs list such as "0-3,8-11"; empty if the file
+    // cannot be read 
+    static std::vector<size_t> read_list(const std::string& path) {
+        std::vector<size_t> values;
+        std::ifstream in(path.c_str());
+        std::string item;
+        while (std::getline(in, item, ',')) {
+            std::istringstream range(item);
+            size_t first = 0;
+            size_t last = 0;
+            char dash = 0;
+            if (!(range >> first)) {
+                continue;
+            }
+            if (!(range >> dash >> last) || dash != '-') {
+                last = first;
+            }
+            for (size_t v = first; v <= last; ++v) {
+                values.push_back(v);
+            }
+        }
+        return values;
+    }
+
+    std::vector<size_t> _node_of_cpu;
+#endif
+
+    size_t _node_count = 1;
+};
+
+// Class providing a thread-safe cache of a function with
+// signature V f(K), made of one shared_lru_cache_using_std per
+// NUMA node, so that the mutex and the list nodes of a cache
+// are only touched by the threads of one node. Each call goes
+// to the cache of the node that the calling thread is running
+// on; hot keys are thus cached once per node. Optionally, a
+// key missing from the local cache is looked up in the other
+// nodes' caches before evaluating the function, trading a
+// remote hit for an evaluation. 
+//
+// Memory is placed by first touch: the cache of a node is only
+// created when a thread running on that node first uses it, and
+// its entries are allocated by the threads of the node, so with
+// the default (local) allocation policy they end up in the
+// node's memory. Threads are not pinned, so a thread that the
+// scheduler moves mid-call may still touch a remote cache, and
+// allocators that hand memory freed on one node to another
+// node will blur the placement. 
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class numa_lru_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    typedef shared_lru_cache_using_std<key_type, value_type, MAP> shard_type;
+    typedef typename shard_type::function_type function_type;
+    typedef typename shard_type::hit_rate hit_rate;
+
+    // Constructor specifies the cached function, the maximum 
+    // number of records to be stored (split evenly between the
+    // nodes), whether to look up keys in the other nodes' caches,
+    // and the number of nodes (0 to detect it) 
+    numa_lru_cache_using_std(
+        function_type f,
+        size_t c,
+        bool cross_node_lookup = false,
+        size_t nodes = 0
+    )
+        : _fn(f)
+        , _node_count(nodes != 0 ? nodes : _topology.node_count())
+        , _shard_capacity(std::max<size_t>(c / _node_count, 1))
+        , _cross_node_lookup(cross_node_lookup)
+        , _shards(new std::atomic<shard_type*>[_node_count])
+        , _shard_created(new std::once_flag[_node_count])
+    {
+        for (size_t i = 0; i < _node_count; ++i) {
+            _shards[i].store(nullptr, std::memory_order_relaxed);
+        }
+    }
+
+    ~numa_lru_cache_using_std() {
+        for (size_t i = 0; i < _node_count; ++i) {
+            delete _shards[i].load(std::memory_order_relaxed);
+        }
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+        const size_t node = _topology.current_node() % _node_count;
+        shard_type& local = shard(node);
+
+        if (_cross_node_lookup && !local.contains(k)) {
+            for (size_t i = 1; i < _node_count; ++i) {
+                const size_t other = (node + i) % _node_count;
+
+                // Caches of other nodes are not created here,
+                // and if the key is evicted after contains(),
+                // it is evaluated in the other node's cache 
+                shard_type* remote = _shards[other].load(std::memory_order_acquire);
+                if (remote && remote->contains(k)) {
+                    return (*remote)(k);
+                }
+            }
+        }
+
+        return local(k);
+    }
+
+    // Find out if the cache of any node has some value
+    bool has(const key_type& k) const {
+        for (size_t i = 0; i < _node_count; ++i) {
+            const shard_type* s = _shards[i].load(std::memory_order_acquire);
+            if (s && s->has(k)) {
+                return true;
+            }
+        }
+        return false;
+    }
+
+    // Remove k from the caches of all nodes; returns true if any
+    // had a cached value 
+    bool erase(const key_type& k) {
+        _invalidations.fetch_add(1, std::memory_order_seq_cst);
+        bool erased = false;
+        for (size_t i = 0; i < _node_count; ++i) {
+            shard_type* s = _shards[i].load(std::memory_order_seq_cst);
+            if (s && s->erase(k)) {
+                erased = true;
+            }
+        }
+        return erased;
+    }
+
+    // See shared_lru_cache_using_std::invalidate_all() 
+    void invalidate_all() {
+        _invalidations.fetch_add(1, std::memory_order_seq_cst);
+        for (size_t i = 0; i < _node_count; ++i) {
+            shard_type* s = _shards[i].load(std::memory_order_seq_cst);
+            if (s) {
+                s->invalidate_all();
+            }
+        }
+    }
+
+    size_t get_node_count() const {
+        return _node_count;
+    }
+
+    // Number of nodes whose cache has been created 
+    size_t get_created_node_count() const {
+        size_t count = 0;
+        for (size_t i = 0; i < _node_count; ++i) {
+            if (_shards[i].load(std::memory_order_acquire)) {
+                ++count;
+            }
+        }
+        return count;
+    }
+
+    // The hit rates of all nodes added up 
+    hit_rate get_hit_rate() const {
+        hit_rate total;
+        for (size_t i = 0; i < _node_count; ++i) {
+            const shard_type* s = _shards[i].load(std::memory_order_acquire);
+            if (s) {
+                const hit_rate h = s->get_hit_rate();
+                total.calls += h.calls;
+                total.hits += h.hits;
+                total.late_hits += h.late_hits;
+                total.negative_hits += h.negative_hits;
+                total.failure_hits += h.failure_hits;
+            }
+        }
+        return total;
+    }
+
+private:
+
+    numa_lru_cache_using_std(const numa_lru_cache_using_std&);
+    numa_lru_cache_using_std& operator=(const numa_lru_cache_using_std&);
+
+    // The cache of a node, created on first use by a thread
+    // running on the node, so that its memory is allocated there.
+    // Invalidations skip the caches not created yet; one that
+    // races with the creation of a cache either finds the cache,
+    // or changes _invalidations before the cache is published,
+    // and the new cache is then invalidated as a whole (so that
+    // no evaluation started in it meanwhile stores its result) 
+    shard_type& shard(size_t node) {
+        std::call_once(_shard_created[node], [this, node]() {
+            const uint64_t invalidations = _invalidations.load(std::memory_order_seq_cst);
+            shard_type* s = new shard_type(_fn, _shard_capacity);
+            if (_cross_node_lookup) {
+                enable_contains_filter(*s, std::is_default_constructible<std::hash<key_type> >());
+            }
+            _shards[node].store(s, std::memory_order_seq_cst);
+            if (_invalidations.load(std::memory_order_seq_cst) != invalidations) {
+                s->invalidate_all();
+            }
+        });
+        return *_shards[node].load(std::memory_order_acquire);
+    }
+
+    // Cross-node lookups call contains() on every miss, so
+    // they are cheaper with the filter; it needs std::hash, and
+    // without it contains() just locks the cache 
+    static void enable_contains_filter(shard_type& s, std::true_type) {
+        s.enable_contains_filter();
+    }
+
+    static void enable_contains_filter(shard_type&, std::false_type) {
+    }
+
+    const function_type _fn;
+
+    const numa_topology _topology;
+    const size_t _node_count;
+    const size_t _shard_capacity;
+    const bool _cross_node_lookup;
+
+    // Caches of the nodes, null until created 
+    const std::unique_ptr<std::atomic<shard_type*>[]> _shards;
+    const std::unique_ptr<std::once_flag[]> _shard_created;
+
+    // Number of invalidations started 
+    std::atomic<uint64_t> _invalidations { 0 };
+};
+
+#endif // _numa_lru_cache_using_std_
@@ -18,9 +18,20 @@
 #define _shared_lru_cache_using_std_ 
 
 #include "lru_cache_using_std.h"
+#include "expiring_map_using_std.h"
+#include "fibonacci_hash.h"
+#include "stopwatch.h"
 #include <unordered_set>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <exception>
+#include <iterator>
+#include <memory>
 #include <mutex>
 #include <thread>
+#include <vector>
 
 // A thread-safe variant of lru_cache_using_std that
 // remains available for reading when the function is
@@ -38,6 +49,25 @@ public:
     typedef V value_type;
     typedef std::function<value_type(const key_type&)> function_type;
 
+    typedef typename lru_cache_using_std<key_type, value_type, MAP>::promotion_policy promotion_policy;
+    typedef typename lru_cache_using_std<key_type, value_type, MAP>::removal_cause removal_cause;
+
+    // A key-value pair removed from the cache 
+    struct removal {
+        key_type key;
+        value_type value;
+        removal_cause cause;
+    };
+
+    // Receives removed key-value pairs in batches 
+    typedef std::function<void(const std::vector<removal>&)> removal_listener_type;
+
+    // Tells whether a value returned by the cached function
+    // means that there is nothing to be found for the key 
+    typedef std::function<bool(const value_type&)> is_absent_type;
+
+    typedef std::chrono::steady_clock clock_type;
+
     // Constructor specifies the cached function and 
     // the maximum number of records to be stored 
     shared_lru_cache_using_std(
@@ -46,7 +76,20 @@ public:
     )
         : _underlying_lru_cache(f, c)
         , _fn(f)
+        , _membership_bits(membership_bits_for(c))
     {
+        _underlying_lru_cache.set_removal_callback(
+            [this](const key_type& k, const value_type& v, removal_cause cause) {
+                if (cause != removal_cause::replaced) {
+                    remove_membership(k);
+                }
+                if (_has_removal_listener.load(std::memory_order_relaxed)) {
+                    const removal r = { k, v, cause };
+                    std::lock_guard<std::mutex> guard(_removals_mutex);
+                    _pending_removals.push_back(r);
+                }
+            }
+        );
     }
 
     // Obtain value of the cached function for k 
@@ -67,68 +110,316 @@ public:
             }
         }
 
-        const auto this_thread_id = std::this_thread::get_id();
+        if (const auto absent = find_negative(k)) {
+            std::lock_guard<std::mutex> guard(_hit_rate_mutex);
+            ++_hit_rate.negative_hits;
+            return *absent;
+        }
+
+        if (const std::exception_ptr failure = find_failure(k)) {
+            {
+                std::lock_guard<std::mutex> guard(_hit_rate_mutex);
+                ++_hit_rate.failure_hits;
+            }
+            std::rethrow_exception(failure);
+        }
+
+        const value_type v = evaluate_once(k);
+
+        // Only now that k is no longer locked, so that a slow or
+        // re-entrant removal listener does not hold up (or
+        // deadlock with) threads waiting for k
+        deliver_removals(false);
+
+        return v;
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        return _underlying_lru_cache.has(k);
+    }
+
+    // Time in seconds that it took to evaluate the cached value
+    // of k; 0 if k is not in the cache, or if its value was set
+    // by load() 
+    double get_cost(const key_type& k) const {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        return _underlying_lru_cache.get_cost(k);
+    }
+
+    // Same as has(), but once enable_contains_filter() has been
+    // called, most keys that are not in the cache are rejected
+    // without locking: a counting filter over key hashes is
+    // consulted first, and the lock is taken only if the filter
+    // says the key may be present
+    bool contains(const key_type& k) const {
+        if (_membership_enabled.load(std::memory_order_acquire)
+                && _membership_counts[membership_slot(k)].load(std::memory_order_acquire) == 0) {
+            return false;
+        }
+        return has(k);
+    }
+
+    // Start keeping the filter used by contains(), with
+    // twice as many slots as the capacity. It cannot be
+    // disabled again, and calling this more than once has no
+    // further effect.
+    template <typename HASH = std::hash<key_type> >
+    void enable_contains_filter(HASH hash = HASH()) {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        if (_membership_enabled.load(std::memory_order_relaxed)) {
+            return;
+        }
+        _membership_hash = hash;
+        _membership_counts.reset(new std::atomic<uint32_t>[size_t(1) << _membership_bits]);
+        for (size_t i = 0, n = size_t(1) << _membership_bits; i < n; ++i) {
+            _membership_counts[i].store(0, std::memory_order_relaxed);
+        }
+        std::vector<key_type> keys;
+        _underlying_lru_cache.get_keys(std::back_inserter(keys));
+        for (const key_type& k : keys) {
+            add_membership(k);
+        }
+        _membership_enabled.store(true, std::memory_order_release);
+    }
+
+    // Write the contents of the cache to os; see
+    // lru_cache_using_std::save(). The cache is locked
+    // while writing.
+    template <typename SERIALIZER>
+    void save(std::ostream& os, SERIALIZER serialize) const {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        _underlying_lru_cache.save(os, serialize);
+    }
 
-        std::shared_ptr<std::mutex> key_specific_mutex = nullptr;
+    // Read key-value pairs written by save(); see
+    // lru_cache_using_std::load(). Unlike there, keys that are
+    // already present keep their values. The cache is locked
+    // only briefly for each pair, so it remains available
+    // while a large snapshot is being read.
+    template <typename DESERIALIZER>
+    size_t load(std::istream& is, DESERIALIZER deserialize) {
+        size_t count = 0;
+        key_type k;
+        value_type v;
+        while (deserialize(is, k, v)) {
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+            if (_underlying_lru_cache.set(k, v)) {
+                add_membership(k);
+            }
+            ++count;
+        }
+        deliver_removals(false);
+        return count;
+    }
 
+    // Remove k from the cache, along with any cached absence or
+    // failure. An evaluation of k that is in progress will not
+    // store its result. Returns true if k had a cached value.
+    bool erase(const key_type& k) {
+        bool erased = false;
         {
-            std::lock_guard<std::mutex> guard(_is_being_evaluated_mutex);
-            auto i = _is_being_evaluated.find(k);
-            if (i == _is_being_evaluated.end()) {
-                _is_being_evaluated[k].mutex = std::shared_ptr<std::mutex>(new std::mutex);
-                i = _is_being_evaluated.find(k);
-            }
-            key_specific_mutex = i->second.mutex;
-            assert(i->second.active_threads.find(this_thread_id) == i->second.active_threads.end());
-            i->second.active_threads.insert(this_thread_id);
-        }
-
-        const auto done = [&]() {
-            std::lock_guard<std::mutex> guard(_is_being_evaluated_mutex);
-            auto i = _is_being_evaluated.find(k);
-            assert(i->second.active_threads.find(this_thread_id) != i->second.active_threads.end());
-            i->second.active_threads.erase(this_thread_id);
-            if (i->second.active_threads.empty()) {
-                _is_being_evaluated.erase(i);
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+            erased = _underlying_lru_cache.erase(k);
+            invalidate_evaluation(k);
+        }
+        {
+            std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+            if (_negative_cache) {
+                _negative_cache->erase(k);
             }
-        };
+        }
+        {
+            std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+            if (_failure_cache) {
+                _failure_cache->erase(k);
+            }
+        }
+        _invalidation_version.fetch_add(1, std::memory_order_release);
+        deliver_removals(false);
+        return erased;
+    }
 
-        std::lock_guard<std::mutex> evaluation_guard(*key_specific_mutex);
+    // Remove all key-value pairs (including cached absences)
+    // for which
+    //     bool pred(const K&, const V&)
+    // returns true. As the values being evaluated are not yet
+    // known, no evaluation in progress will store its result.
+    // Returns the number of cached values removed.
+    template <typename PREDICATE>
+    size_t erase_if(PREDICATE pred) {
+        size_t count = 0;
         {
             std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
-            if (_underlying_lru_cache.has(k)) {
-                const value_type v = _underlying_lru_cache.operator()(k);
-                done();
+            count = _underlying_lru_cache.erase_if(pred);
+            invalidate_all_evaluations();
+        }
+        {
+            std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+            if (_negative_cache) {
+                _negative_cache->erase_if(pred);
+            }
+        }
+        _invalidation_version.fetch_add(1, std::memory_order_release);
+        deliver_removals(false);
+        return count;
+    }
 
-                std::lock_guard<std::mutex> guard(_hit_rate_mutex);
-                ++_hit_rate.late_hits;
+    // Remove everything from the cache, including cached
+    // absences and failures, notifying the removal listener
+    // of each removed value. No evaluation in progress will
+    // store its result.
+    void invalidate_all() {
+        {
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+            _underlying_lru_cache.invalidate_all();
+            invalidate_all_evaluations();
+        }
+        clear_tombstones();
+        _invalidation_version.fetch_add(1, std::memory_order_release);
+        deliver_removals(false);
+    }
 
-                return v;
+    // Same as invalidate_all(), but without notifying the
+    // removal listener 
+    void clear() {
+        {
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+            _underlying_lru_cache.clear();
+            if (_membership_counts) {
+                for (size_t i = 0, n = size_t(1) << _membership_bits; i < n; ++i) {
+                    _membership_counts[i].store(0, std::memory_order_release);
+                }
             }
+            invalidate_all_evaluations();
         }
+        clear_tombstones();
+        _invalidation_version.fetch_add(1, std::memory_order_release);
+    }
+
+    // Current generation of the whole cache: changes whenever
+    // all keys, or keys selected by erase_if(), are invalidated.
+    // Evaluations that span a change do not store their results.
+    uint64_t get_generation() const {
+        return _generation.load(std::memory_order_acquire);
+    }
 
-        const value_type v = _fn(k);
+    // Changes at the end of every erase(), erase_if(),
+    // invalidate_all() and clear(). A value obtained from the
+    // cache may be kept elsewhere for as long as this does not
+    // change, if it was read before obtaining the value.
+    uint64_t get_invalidation_version() const {
+        return _invalidation_version.load(std::memory_order_acquire);
+    }
 
+    // Register a function to be called with removed key-value
+    // pairs. Removals are collected while the cache is locked,
+    // but delivered only after it has been unlocked, by one of
+    // the threads that caused them, in batches of at least
+    // batch_size pairs (flush_removals() delivers the rest).
+    // The listener is never called concurrently with itself,
+    // and the delivering thread holds no cache lock and is not
+    // evaluating any key (other threads may be). It may call
+    // the cache, but not flush_removals().
+    void set_removal_listener(removal_listener_type listener, size_t batch_size = 1) {
+        assert(batch_size != 0);
         {
-            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
-            assert(!_underlying_lru_cache.has(k));
-            _underlying_lru_cache.set(k, v);
+            std::lock_guard<std::mutex> guard(_removals_mutex);
+            _removal_listener = listener;
+            _removal_batch_size = batch_size;
         }
+        _has_removal_listener.store(static_cast<bool>(listener), std::memory_order_relaxed);
+    }
 
-        done();
-        return v;
+    // Deliver all collected removals now 
+    void flush_removals() {
+        deliver_removals(true);
     }
 
-    // Find out if the cache already has some value
-    // NOTE: not thread-safe at the moment! (for perf reasons)
-    bool has(const key_type& k) const {
-        return _underlying_lru_cache.has(k);
+    typedef typename lru_cache_using_std<key_type, value_type, MAP>::recompute_stats recompute_stats;
+
+    // See lru_cache_using_std::enable_recompute_tracking() 
+    void enable_recompute_tracking(size_t ghost_capacity) {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        _underlying_lru_cache.enable_recompute_tracking(ghost_capacity);
+    }
+
+    void disable_recompute_tracking() {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        _underlying_lru_cache.disable_recompute_tracking();
+    }
+
+    recompute_stats get_recompute_stats() const {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        return _underlying_lru_cache.get_recompute_stats();
+    }
+
+    typedef typename lru_cache_using_std<key_type, value_type, MAP>::capacity_curve_point capacity_curve_point;
+
+    // See lru_cache_using_std::get_capacity_curve() 
+    std::vector<capacity_curve_point> get_capacity_curve() const {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        return _underlying_lru_cache.get_capacity_curve();
+    }
+
+    // Change the way hits update the access history; skipping
+    // promotions means hits write to fewer shared list nodes
+    void set_promotion_policy(const promotion_policy& p) {
+        std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+        _underlying_lru_cache.set_promotion_policy(p);
+    }
+
+    // Cache "absent" results separately from the actual values:
+    // keys for which the function returns a value that satisfies
+    // is_absent are remembered for the given time (at most
+    // capacity of them), and further calls for those keys are
+    // answered without evaluating the function again
+    void enable_negative_caching(
+        is_absent_type is_absent,
+        size_t capacity,
+        clock_type::duration ttl
+    ) {
+        std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+        _is_absent = is_absent;
+        _negative_cache.reset(new negative_cache_type(capacity, ttl));
+        _negative_caching_enabled.store(true, std::memory_order_release);
+    }
+
+    void disable_negative_caching() {
+        std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+        _negative_caching_enabled.store(false, std::memory_order_release);
+        _negative_cache.reset();
+        _is_absent = nullptr;
+    }
+
+    // If the cached function throws, the exception is always
+    // propagated to the caller, and to the threads that were
+    // waiting for the same key. With failure caching enabled,
+    // the exception is also remembered for the given backoff
+    // time (for at most capacity keys), and rethrown to further
+    // callers without evaluating the function again
+    void enable_failure_caching(
+        size_t capacity,
+        clock_type::duration backoff
+    ) {
+        std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+        _failure_cache.reset(new failure_cache_type(capacity, backoff));
+        _failure_caching_enabled.store(true, std::memory_order_release);
+    }
+
+    void disable_failure_caching() {
+        std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+        _failure_caching_enabled.store(false, std::memory_order_release);
+        _failure_cache.reset();
     }
 
     struct hit_rate {
         size_t calls = 0;
         size_t hits = 0;
         size_t late_hits = 0;
+        size_t negative_hits = 0;
+        size_t failure_hits = 0;
     };
 
     hit_rate get_hit_rate() const {
@@ -141,24 +432,386 @@ public:
         _hit_rate.calls = 0;
         _hit_rate.hits = 0;
         _hit_rate.late_hits = 0;
+        _hit_rate.negative_hits = 0;
+        _hit_rate.failure_hits = 0;
+    }
+
+    // Timing of the evaluations of the cached function,
+    // including those that threw 
+    struct load_stats {
+        size_t loads = 0;
+        size_t failures = 0;
+        double total_seconds = 0.0;
+        double max_seconds = 0.0;
+    };
+
+    load_stats get_load_stats() const {
+        std::lock_guard<std::mutex> guard(_load_stats_mutex);
+        return _load_stats;
+    }
+
+    void reset_load_stats() {
+        std::lock_guard<std::mutex> guard(_load_stats_mutex);
+        _load_stats = load_stats();
     }
 
 private:
 
+    // Use at least twice as many filter slots as the capacity,
+    // rounded up to a power of two
+    static unsigned int membership_bits_for(size_t capacity) {
+        unsigned int bits = 1;
+        while ((size_t(1) << bits) < 2 * capacity) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    size_t membership_slot(const key_type& k) const {
+        return fibonacci_slot(static_cast<uint64_t>(_membership_hash(k)), _membership_bits);
+    }
+
+    // Keep the filter of contains() in sync with the underlying
+    // cache, if enabled; called holding _underlying_lru_cache_mutex 
+    void add_membership(const key_type& k) {
+        if (_membership_counts) {
+            _membership_counts[membership_slot(k)].fetch_add(1, std::memory_order_release);
+        }
+    }
+
+    void remove_membership(const key_type& k) {
+        if (_membership_counts) {
+            _membership_counts[membership_slot(k)].fetch_sub(1, std::memory_order_release);
+        }
+    }
+
+    // If k is known to be absent, get the value that says so 
+    std::unique_ptr<value_type> find_negative(const key_type& k) {
+        if (!_negative_caching_enabled.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+        if (!_negative_cache) {
+            return nullptr;
+        }
+        const value_type* absent = _negative_cache->find(k, clock_type::now());
+        if (!absent) {
+            return nullptr;
+        }
+        return std::unique_ptr<value_type>(new value_type(*absent));
+    }
+
+    // If v says that k is absent, remember that (instead of
+    // storing v in the underlying cache) and return true 
+    bool store_negative(const key_type& k, const value_type& v) {
+        if (!_negative_caching_enabled.load(std::memory_order_acquire)) {
+            return false;
+        }
+        std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+        if (!_negative_cache || !_is_absent(v)) {
+            return false;
+        }
+        _negative_cache->insert(k, v, clock_type::now());
+        return true;
+    }
+
+    // If evaluating k failed recently, get the exception 
+    std::exception_ptr find_failure(const key_type& k) {
+        if (!_failure_caching_enabled.load(std::memory_order_acquire)) {
+            return nullptr;
+        }
+        std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+        if (!_failure_cache) {
+            return nullptr;
+        }
+        const std::exception_ptr* failure = _failure_cache->find(k, clock_type::now());
+        return failure ? *failure : nullptr;
+    }
+
+    void store_failure(const key_type& k, std::exception_ptr failure) {
+        if (!_failure_caching_enabled.load(std::memory_order_acquire)) {
+            return;
+        }
+        std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+        if (_failure_cache) {
+            _failure_cache->insert(k, failure, clock_type::now());
+        }
+    }
+
+    class evaluation_registration;
+
+    // Identifies the invalidations that have affected a key:
+    // a value evaluated for the key may be stored only if its
+    // generation did not change during the evaluation 
+    struct evaluation_generation {
+        uint64_t global;
+        uint64_t key;
+
+        bool operator==(const evaluation_generation& that) const {
+            return global == that.global && key == that.key;
+        }
+    };
+
+    // Evaluate k, unless another thread is doing so: then wait
+    // for it, and use its result 
+    value_type evaluate_once(const key_type& k) {
+        const evaluation_registration registration(*this, k);
+
+        std::lock_guard<std::mutex> evaluation_guard(registration.mutex());
+        {
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+            if (_underlying_lru_cache.has(k)) {
+                const value_type v = _underlying_lru_cache.operator()(k);
+
+                std::lock_guard<std::mutex> guard(_hit_rate_mutex);
+                ++_hit_rate.late_hits;
+
+                return v;
+            }
+        }
+
+        if (const auto absent = find_negative(k)) {
+            std::lock_guard<std::mutex> guard(_hit_rate_mutex);
+            ++_hit_rate.negative_hits;
+
+            return *absent;
+        }
+
+        // If an evaluation of k failed while we were waiting,
+        // fail the same way instead of retrying right away
+        if (const std::exception_ptr failure = registration.failure()) {
+            {
+                std::lock_guard<std::mutex> guard(_hit_rate_mutex);
+                ++_hit_rate.failure_hits;
+            }
+            std::rethrow_exception(failure);
+        }
+
+        const evaluation_generation generation = current_generation(registration);
+
+        double cost = 0.0;
+        const value_type v = evaluate(k, registration, generation, cost);
+
+        {
+            std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+
+            // If k was invalidated while evaluating, the value
+            // may be stale: return it, but do not keep it
+            // (load() may have set a value for k meanwhile: then
+            // keep that one)
+            if (current_generation(registration) == generation && !store_negative(k, v)) {
+                if (_underlying_lru_cache.set(k, v, cost)) {
+                    add_membership(k);
+                }
+            }
+        }
+
+        return v;
+    }
+
+    // Evaluate the cached function, making any exception
+    // available to the other threads waiting for k, and
+    // setting cost to the time taken in seconds 
+    value_type evaluate(
+        const key_type& k,
+        const evaluation_registration& registration,
+        const evaluation_generation& generation,
+        double& cost
+    ) {
+        const stopwatch timer;
+        try {
+            const value_type v = _fn(k);
+            cost = timer.elapsed_seconds();
+            record_load(cost, false);
+            registration.finish(nullptr);
+            return v;
+        }
+        catch (...) {
+            record_load(timer.elapsed_seconds(), true);
+            const std::exception_ptr failure = std::current_exception();
+            registration.finish(failure);
+            {
+                // As with values, a failure is not kept if k was
+                // invalidated while evaluating 
+                std::lock_guard<std::mutex> guard(_underlying_lru_cache_mutex);
+                if (current_generation(registration) == generation) {
+                    store_failure(k, failure);
+                }
+            }
+            throw;
+        }
+    }
+
+    void record_load(double seconds, bool failed) {
+        std::lock_guard<std::mutex> guard(_load_stats_mutex);
+        ++_load_stats.loads;
+        if (failed) {
+            ++_load_stats.failures;
+        }
+        _load_stats.total_seconds += seconds;
+        _load_stats.max_seconds = std::max(_load_stats.max_seconds, seconds);
+    }
+
+    evaluation_generation current_generation(const evaluation_registration& registration) const {
+        const evaluation_generation generation = {
+            _generation.load(std::memory_order_acquire),
+            registration.generation()
+        };
+        return generation;
+    }
+
+    // Make an evaluation in progress for k not store its
+    // result, and threads waiting for k not share a failure;
+    // must be called while holding _underlying_lru_cache_mutex 
+    void invalidate_evaluation(const key_type& k) {
+        std::lock_guard<std::mutex> guard(_is_being_evaluated_mutex);
+        const auto i = _is_being_evaluated.find(k);
+        if (i != _is_being_evaluated.end()) {
+            ++i->second.generation;
+            i->second.failure = nullptr;
+        }
+    }
+
+    // Same for all keys, in constant time 
+    void invalidate_all_evaluations() {
+        _generation.fetch_add(1, std::memory_order_acq_rel);
+    }
+
+    void clear_tombstones() {
+        {
+            std::lock_guard<std::mutex> guard(_negative_cache_mutex);
+            if (_negative_cache) {
+                _negative_cache->clear();
+            }
+        }
+        {
+            std::lock_guard<std::mutex> guard(_failure_cache_mutex);
+            if (_failure_cache) {
+                _failure_cache->clear();
+            }
+        }
+    }
+
+    // Pass collected removals to the listener, as long as there
+    // is a full batch of them (or any, if flushing). Unless
+    // flushing, this returns right away if removals are being
+    // delivered already (possibly by the listener calling the
+    // cache): that delivery picks up the new ones when done.
+    void deliver_removals(bool flush) {
+        if (!_has_removal_listener.load(std::memory_order_relaxed)) {
+            return;
+        }
+
+        const std::thread::id this_thread = std::this_thread::get_id();
+        if (_removal_delivery_thread.load(std::memory_order_relaxed) == this_thread) {
+            // Called by the listener
+            return;
+        }
+
+        for (;;) {
+            {
+                std::unique_lock<std::mutex> delivery_lock(_removal_delivery_mutex, std::try_to_lock);
+                if (!delivery_lock.owns_lock()) {
+                    if (!flush) {
+                        return;
+                    }
+                    delivery_lock.lock();
+                }
+                _removal_delivery_thread.store(this_thread, std::memory_order_relaxed);
+
+                for (;;) {
+                    std::vector<removal> removals;
+                    removal_listener_type listener;
+                    {
+                        std::lock_guard<std::mutex> guard(_removals_mutex);
+                        if (!has_pending_removals(flush)) {
+                            break;
+                        }
+                        removals.swap(_pending_removals);
+                        listener = _removal_listener;
+                    }
+
+                    if (listener) {
+                        try {
+                            listener(removals);
+                        }
+                        catch (...) {
+                            _removal_delivery_thread.store(std::thread::id(), std::memory_order_relaxed);
+                            throw;
+                        }
+                    }
+                }
+                _removal_delivery_thread.store(std::thread::id(), std::memory_order_relaxed);
+            }
+
+            // Another thread may have given up on delivering
+            // just before we were done
+            std::lock_guard<std::mutex> guard(_removals_mutex);
+            if (!has_pending_removals(false)) {
+                return;
+            }
+            flush = false;
+        }
+    }
+
+    // Tells whether deliver_removals() has something to do;
+    // _removals_mutex must be held 
+    bool has_pending_removals(bool flush) const {
+        return !_pending_removals.empty() && (flush || _pending_removals.size() >= _removal_batch_size);
+    }
+
     typedef lru_cache_using_std<key_type, value_type, MAP> lru_cache_type;
 
     // The underlying, non-thread-safe LRU cache
     lru_cache_type _underlying_lru_cache;
 
     // This mutex guards the underlying LRU cache
-    std::mutex _underlying_lru_cache_mutex;
+    mutable std::mutex _underlying_lru_cache_mutex;
 
     // The function to be cached 
     const function_type _fn;
 
+    // Removals waiting to be delivered to the listener 
+    std::vector<removal> _pending_removals;
+    removal_listener_type _removal_listener;
+    size_t _removal_batch_size = 1;
+
+    // Allows skipping _removals_mutex when there is no listener 
+    std::atomic<bool> _has_removal_listener { false };
+
+    // This mutex guards _pending_removals, _removal_listener
+    // and _removal_batch_size
+    std::mutex _removals_mutex;
+
+    // Serializes calls to the removal listener 
+    std::mutex _removal_delivery_mutex;
+
+    // The thread holding _removal_delivery_mutex, if any 
+    std::atomic<std::thread::id> _removal_delivery_thread { std::thread::id() };
+
+    // Counting filter of the keys in the underlying cache, null
+    // until enable_contains_filter(): updated while holding
+    // _underlying_lru_cache_mutex, but read without it once
+    // _membership_enabled is set
+    const unsigned int _membership_bits;
+    std::function<size_t(const key_type&)> _membership_hash;
+    std::unique_ptr<std::atomic<uint32_t>[]> _membership_counts;
+    std::atomic<bool> _membership_enabled { false };
+
     struct is_being_evaluated {
         std::shared_ptr<std::mutex> mutex;
         std::unordered_set<std::thread::id> active_threads;
+
+        // Number of evaluations of the key that have finished 
+        uint64_t evaluations = 0;
+
+        // Set if the last evaluation threw, which was number
+        // failed_evaluation 
+        std::exception_ptr failure;
+        uint64_t failed_evaluation = 0;
+
+        // Incremented whenever the key alone is invalidated 
+        uint64_t generation = 0;
     };
 
     typedef MAP<
@@ -171,9 +824,121 @@ private:
     // This mutex guards the _is_being_evaluated object
     std::mutex _is_being_evaluated_mutex;
 
+    // Generation of the whole cache; modified only while
+    // holding _underlying_lru_cache_mutex 
+    std::atomic<uint64_t> _generation { 0 };
+
+    // See get_invalidation_version() 
+    std::atomic<uint64_t> _invalidation_version { 0 };
+
+    // Registers the calling thread in _is_being_evaluated for
+    // the lifetime of the object, so that the registration is
+    // removed also when the function throws
+    class evaluation_registration {
+    public:
+        evaluation_registration(shared_lru_cache_using_std& cache, const key_type& k)
+            : _cache(cache)
+            , _k(k)
+            , _thread_id(std::this_thread::get_id())
+        {
+            std::lock_guard<std::mutex> guard(_cache._is_being_evaluated_mutex);
+            auto i = _cache._is_being_evaluated.find(_k);
+            if (i == _cache._is_being_evaluated.end()) {
+                _cache._is_being_evaluated[_k].mutex = std::shared_ptr<std::mutex>(new std::mutex);
+                i = _cache._is_being_evaluated.find(_k);
+            }
+            _mutex = i->second.mutex;
+            _registered_after = i->second.evaluations;
+            assert(i->second.active_threads.find(_thread_id) == i->second.active_threads.end());
+            i->second.active_threads.insert(_thread_id);
+        }
+
+        ~evaluation_registration() {
+            std::lock_guard<std::mutex> guard(_cache._is_being_evaluated_mutex);
+            auto i = _cache._is_being_evaluated.find(_k);
+            assert(i->second.active_threads.find(_thread_id) != i->second.active_threads.end());
+            i->second.active_threads.erase(_thread_id);
+            if (i->second.active_threads.empty()) {
+                _cache._is_being_evaluated.erase(i);
+            }
+        }
+
+        // Serializes the evaluation of the key 
+        std::mutex& mutex() const {
+            return *_mutex;
+        }
+
+        // Exception thrown by the last evaluation of the key,
+        // if it finished after this thread registered; failures
+        // that happened earlier are left to failure caching 
+        std::exception_ptr failure() const {
+            std::lock_guard<std::mutex> guard(_cache._is_being_evaluated_mutex);
+            const is_being_evaluated& activity = _cache._is_being_evaluated.find(_k)->second;
+            if (activity.failed_evaluation <= _registered_after) {
+                return nullptr;
+            }
+            return activity.failure;
+        }
+
+        uint64_t generation() const {
+            std::lock_guard<std::mutex> guard(_cache._is_being_evaluated_mutex);
+            return _cache._is_being_evaluated.find(_k)->second.generation;
+        }
+
+        // Record the outcome of an evaluation by this thread 
+        void finish(std::exception_ptr failure) const {
+            std::lock_guard<std::mutex> guard(_cache._is_being_evaluated_mutex);
+            is_being_evaluated& activity = _cache._is_being_evaluated.find(_k)->second;
+            ++activity.evaluations;
+            activity.failure = failure;
+            activity.failed_evaluation = failure ? activity.evaluations : 0;
+        }
+
+    private:
+        evaluation_registration(const evaluation_registration&);
+        evaluation_registration& operator=(const evaluation_registration&);
+
+        shared_lru_cache_using_std& _cache;
+        const key_type& _k;
+        const std::thread::id _thread_id;
+        std::shared_ptr<std::mutex> _mutex;
+
+        // Evaluations of the key finished before registering 
+        uint64_t _registered_after = 0;
+    };
+
+    typedef expiring_map_using_std<key_type, value_type, MAP> negative_cache_type;
+
+    // Keys recently found to be absent, if negative caching
+    // is enabled
+    std::unique_ptr<negative_cache_type> _negative_cache;
+    is_absent_type _is_absent;
+
+    // Allows skipping _negative_cache_mutex when negative
+    // caching is not enabled
+    std::atomic<bool> _negative_caching_enabled { false };
+
+    // This mutex guards _negative_cache and _is_absent
+    std::mutex _negative_cache_mutex;
+
+    typedef expiring_map_using_std<key_type, std::exception_ptr, MAP> failure_cache_type;
+
+    // Keys whose evaluation recently failed, if failure
+    // caching is enabled
+    std::unique_ptr<failure_cache_type> _failure_cache;
+
+    std::atomic<bool> _failure_caching_enabled { false };
+
+    // This mutex guards _failure_cache
+    std::mutex _failure_cache_mutex;
+
     hit_rate _hit_rate;
 
     mutable std::mutex _hit_rate_mutex;
+
+    load_stats _load_stats;
+
+    mutable std::mutex _load_stats_mutex;
 };
 
 #endif // _shared_lru_cache_using_std_
@@ -0,0 +1,218 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _slru_cache_using_std_ 
+#define _slru_cache_using_std_ 
+
+#include <cassert> 
+#include <cstddef>
+#include <list>
+#include <functional> // for std::function
+
+// Class providing fixed-size (by number of records) 
+// segmented LRU cache of a function with signature 
+// V f(K), with the same interface as lru_cache_using_std. 
+//
+// New records enter a probationary segment, and are promoted
+// to a protected segment only when hit again. Records demoted
+// from the protected segment get another chance in the
+// probationary one, and only probationary records are evicted,
+// so keys seen just once (as in a scan) cannot push out keys
+// that have proven to be popular.
+// MAP should be one of std::map or std::unordered_map. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class slru_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    // Key access history, most recent at back 
+    typedef std::list<key_type> key_tracker_type;
+
+    enum segment_id { probationary, protected_ };
+
+    // Cached value, and where its key is 
+    struct record_type {
+        value_type value;
+        segment_id segment;
+        typename key_tracker_type::iterator tracker_iterator;
+    };
+
+    typedef MAP<key_type, record_type> key_to_value_type;
+
+    typedef std::function<value_type(const key_type&)> function_type;
+
+    // Constructor specifies the cached function, the maximum 
+    // number of records to be stored, and the fraction of them 
+    // that may be in the protected segment 
+    slru_cache_using_std(
+        function_type f,
+        size_t c,
+        double protected_fraction = 0.8
+    )
+        : _fn(f)
+        , _capacity(c)
+        , _protected_capacity(static_cast<size_t>(c * protected_fraction))
+    {
+        assert(_capacity != 0);
+        assert(protected_fraction >= 0.0 && protected_fraction <= 1.0);
+
+        // Keep at least one probationary slot, so that new
+        // records can be admitted 
+        if (_protected_capacity >= _capacity) {
+            _protected_capacity = _capacity - 1;
+        }
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+
+        // Attempt to find existing record 
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(k);
+
+        if (it != _key_to_value.end()) {
+
+            // We do have it: promote or refresh it in the
+            // protected segment 
+            record_type& record = (*it).second;
+            promote(record);
+            return record.value;
+        }
+
+        // We don't have it: evaluate function and create
+        // new record 
+        const value_type v = _fn(k);
+        insert(k, v);
+        return v;
+    }
+
+    // Obtain the cached keys, most recently used element 
+    // of the protected segment at head, least recently used
+    // element of the probationary segment at tail. 
+    // This method is provided purely to support testing. 
+    template <typename IT> void get_keys(IT dst) const {
+        for (segment_id s : { protected_, probationary }) {
+            typename key_tracker_type::const_reverse_iterator src
+                = _segments[s].rbegin();
+            while (src != _segments[s].rend()) {
+                *dst++ = *src++;
+            }
+        }
+    }
+
+    // Find out if the cache already has some value
+    bool has(const key_type& k) const {
+        return _key_to_value.find(k) != _key_to_value.end();
+    }
+
+    // Set a key-value pair that may be missing in the cache;
+    // returns true if the pair was inserted
+    bool set(const key_type& k, const value_type& v) {
+        if (has(k)) {
+            return false;
+        }
+        insert(k, v);
+        return true;
+    }
+
+    // Number of records in a segment 
+    size_t get_segment_size(segment_id s) const {
+        return _segments[s].size();
+    }
+
+private:
+
+    // Record a fresh key-value pair in the probationary segment 
+    void insert(const key_type& k, const value_type& v) {
+
+        // Method is only called on cache misses 
+        assert(_key_to_value.find(k) == _key_to_value.end());
+
+        // Make space if necessary 
+        if (_key_to_value.size() == _capacity) {
+            evict();
+        }
+
+        const typename key_tracker_type::iterator it
+            = _segments[probationary].insert(_segments[probationary].end(), k);
+        const record_type record = { v, probationary, it };
+        _key_to_value.insert(std::make_pair(k, record));
+    }
+
+    // Move a record to the back of the protected segment,
+    // demoting the least recently used protected record if
+    // the segment overflows 
+    void promote(record_type& record) {
+        move_to_back(protected_, record.segment, record.tracker_iterator);
+        record.segment = protected_;
+
+        if (_segments[protected_].size() > _protected_capacity) {
+            const typename key_to_value_type::iterator demoted
+                = _key_to_value.find(_segments[protected_].front());
+            assert(demoted != _key_to_value.end());
+            move_to_back(probationary, protected_, (*demoted).second.tracker_iterator);
+            (*demoted).second.segment = probationary;
+        }
+    }
+
+    // Purge the least-recently-used probationary element 
+    void evict() {
+
+        // Assert method is never called when cache is empty 
+        assert(!_key_to_value.empty());
+
+        // The probationary segment can only be empty when
+        // nothing may be protected 
+        const segment_id s = _segments[probationary].empty() ? protected_ : probationary;
+
+        const typename key_to_value_type::iterator it
+            = _key_to_value.find(_segments[s].front());
+        assert(it != _key_to_value.end());
+
+        _key_to_value.erase(it);
+        _segments[s].pop_front();
+    }
+
+    // Move a key to the back of a segment (possibly another
+    // one); iterators remain valid 
+    void move_to_back(segment_id to, segment_id from, typename key_tracker_type::iterator it) {
+        _segments[to].splice(_segments[to].end(), _segments[from], it);
+    }
+
+    // The function to be cached 
+    const function_type _fn;
+
+    // Maximum number of key-value pairs to be retained 
+    const size_t _capacity;
+
+    // Maximum number of key-value pairs in the protected segment 
+    size_t _protected_capacity;
+
+    // Probationary and protected segments, least recently
+    // used at front 
+    key_tracker_type _segments[2];
+
+    // Key-to-value lookup 
+    key_to_value_type _key_to_value;
+};
+
+#endif // _slru_cache_using_std_
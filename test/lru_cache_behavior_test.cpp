@@ -0,0 +1,1075 @@
+#include "../shared_lru_cache_using_std.h"
+#include "../disk_tier_using_std.h"
+#include "../mapped_snapshot.h"
+#include "../epoch_reclaimer.h"
+#include "../numa_lru_cache_using_std.h"
+#include "../arc_cache_using_std.h"
+#include "../gdsf_cache_using_std.h"
+#include "../lfu_cache_using_std.h"
+#include "../slru_cache_using_std.h"
+#include <map>
+#include <unordered_map>
+#include <atomic>
+#include <cassert>
+#include <chrono>
+#include <cstdio>
+#include <fstream>
+#include <future>
+#include <iostream>
+#include <iterator>
+#include <limits>
+#include <sstream>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+#if defined(__unix__)
+#include <csignal>
+#include <sys/resource.h>
+#endif
+
+// Checks of what the caches and their optional features do,
+// as opposed to how they hold up under load (see
+// shared_lru_cache_stress_test). Each test sets up a small
+// cache, drives it through a scenario, and asserts the outcome.
+
+namespace {
+
+typedef shared_lru_cache_using_std<int, int, std::unordered_map> shared_cache_type;
+
+// Value returned for keys that have nothing to be found
+const int absent = -1;
+
+// Number of times the cached function has been called
+std::atomic<int> evaluations(0);
+
+int square_or_absent(const int& k)
+{
+    ++evaluations;
+    return k < 0 ? absent : k * k;
+}
+
+bool is_absent(const int& v)
+{
+    return v == absent;
+}
+
+int sum_of_pair(const std::pair<int, int>& k)
+{
+    return k.first + k.second;
+}
+
+void test_contains()
+{
+    evaluations = 0;
+    shared_cache_type cache(square_or_absent, 2);
+    cache(1);
+    cache.enable_contains_filter();
+
+    // Keys added before and after enabling the filter are found
+    assert(cache.contains(1));
+    cache(2);
+    assert(cache.contains(2));
+    assert(!cache.contains(3));
+
+    // Gone after eviction and erase
+    cache(3);
+    assert(!cache.contains(1));
+    assert(cache.contains(3));
+    cache.erase(3);
+    assert(!cache.contains(3));
+    assert(cache.contains(2));
+
+    // Gone after invalidate_all and clear
+    cache.invalidate_all();
+    assert(!cache.contains(2));
+    cache(4);
+    assert(cache.contains(4));
+    cache.clear();
+    assert(!cache.contains(4));
+    cache(5);
+    assert(cache.contains(5));
+
+    // Without the filter, keys need not be hashable
+    shared_lru_cache_using_std<std::pair<int, int>, int, std::map> ordered(sum_of_pair, 2);
+    assert(ordered(std::make_pair(1, 2)) == 3);
+    assert(ordered.contains(std::make_pair(1, 2)));
+    assert(!ordered.contains(std::make_pair(2, 1)));
+}
+
+void test_negative_caching()
+{
+    evaluations = 0;
+    shared_cache_type cache(square_or_absent, 4);
+    cache.enable_negative_caching(is_absent, 4, std::chrono::milliseconds(200));
+
+    // An absence is answered without evaluating again, and
+    // takes no space from the values
+    assert(cache(-1) == absent);
+    assert(cache(-1) == absent);
+    assert(evaluations == 1);
+    assert(cache.get_hit_rate().negative_hits == 1);
+    assert(!cache.has(-1));
+
+    // erase_if() removes the absences that match
+    assert(cache(-2) == absent);
+    assert(evaluations == 2);
+    cache.erase_if([](const int& k, const int&) { return k == -1; });
+    assert(cache(-1) == absent);
+    assert(cache(-2) == absent);
+    assert(evaluations == 3);
+
+    // An absence is forgotten once its time to live is over
+    std::this_thread::sleep_for(std::chrono::milliseconds(300));
+    assert(cache(-2) == absent);
+    assert(evaluations == 4);
+
+    // Values are cached as usual
+    assert(cache(3) == 9);
+    assert(cache(3) == 9);
+    assert(evaluations == 5);
+}
+
+// Keys of cache, most recently used first 
+template <typename CACHE>
+std::vector<int> keys_of(const CACHE& cache)
+{
+    std::vector<int> keys;
+    cache.get_keys(std::back_inserter(keys));
+    return keys;
+}
+
+void test_promotion_policy()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+
+    // By default, every hit moves the key to the front
+    lru_cache_type cache(square_or_absent, 4);
+    for (int k = 1; k <= 4; ++k) {
+        cache(k);
+    }
+    cache(2);
+    assert((keys_of(cache) == std::vector<int> { 2, 4, 3, 1 }));
+
+    // Hits on keys promoted within the last half of the
+    // capacity are not promoted again
+    lru_cache_type::promotion_policy recent;
+    recent.recent_fraction = 0.5;
+    cache.set_promotion_policy(recent);
+    cache(4);
+    assert((keys_of(cache) == std::vector<int> { 2, 4, 3, 1 }));
+    cache(3);
+    assert((keys_of(cache) == std::vector<int> { 3, 2, 4, 1 }));
+
+    // With zero probability, other hits are not promoted
+    // either, and keys are evicted in insertion order
+    lru_cache_type::promotion_policy never;
+    never.probability = 0.0;
+    cache.set_promotion_policy(never);
+    cache(1);
+    cache(5);
+    assert(!cache.has(1));
+    assert((keys_of(cache) == std::vector<int> { 5, 3, 2, 4 }));
+}
+
+void test_recompute_tracking()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+
+    // Looping over three keys thrashes a cache of two: every
+    // evaluation after the first round is a recomputation
+    lru_cache_type cache(square_or_absent, 2);
+    cache.enable_recompute_tracking(4);
+    for (int round = 0; round < 2; ++round) {
+        for (int k = 1; k <= 3; ++k) {
+            cache(k);
+        }
+    }
+    lru_cache_type::recompute_stats stats = cache.get_recompute_stats();
+    assert(stats.evaluations == 6);
+    assert(stats.recomputations == 3);
+
+    // New keys and set() are evaluations, but not
+    // recomputations; hits are neither
+    cache(3);
+    cache(4);
+    cache.set(5, 25);
+    stats = cache.get_recompute_stats();
+    assert(stats.evaluations == 8);
+    assert(stats.recomputations == 3);
+
+    // Keys evicted longer ago than the ghost capacity are
+    // forgotten
+    for (int k = 10; k < 20; ++k) {
+        cache(k);
+    }
+    cache(1);
+    assert(cache.get_recompute_stats().recomputations == 3);
+
+    cache.disable_recompute_tracking();
+    cache(2);
+    assert(cache.get_recompute_stats().evaluations == 19);
+}
+
+void test_capacity_curve()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+
+    lru_cache_type cache(square_or_absent, 2);
+    assert(cache.get_capacity_curve().empty());
+
+    // Looping over four keys in a cache of two, every key is
+    // evaluated again two evictions after it was evicted, so
+    // two more slots would turn all those misses into hits
+    cache.enable_recompute_tracking(4);
+    for (int round = 0; round < 2; ++round) {
+        for (int k = 1; k <= 4; ++k) {
+            cache(k);
+        }
+    }
+    const std::vector<lru_cache_type::capacity_curve_point> curve = cache.get_capacity_curve();
+    assert(curve.size() == 4);
+    const size_t expected_capacities[] = { 3, 4, 5, 6 };
+    const size_t expected_additional_hits[] = { 0, 4, 4, 4 };
+    for (size_t i = 0; i < curve.size(); ++i) {
+        assert(curve[i].capacity == expected_capacities[i]);
+        assert(curve[i].additional_hits == expected_additional_hits[i]);
+    }
+}
+
+void write_pair(std::ostream& os, const int& k, const int& v)
+{
+    os << k << ' ' << v << '\n';
+}
+
+bool read_pair(std::istream& is, int& k, int& v)
+{
+    return static_cast<bool>(is >> k >> v);
+}
+
+void test_save_and_load()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+
+    evaluations = 0;
+    lru_cache_type saved(square_or_absent, 3);
+    saved(1);
+    saved(2);
+    saved(3);
+    saved(1);
+    std::stringstream snapshot;
+    saved.save(snapshot, write_pair);
+
+    // The contents and their order are restored, replacing
+    // existing values, and evicting as usual
+    lru_cache_type loaded(square_or_absent, 3);
+    loaded.set(2, 0);
+    loaded.set(4, 16);
+    assert(loaded.load(snapshot, read_pair) == 3);
+    assert((keys_of(loaded) == std::vector<int> { 1, 3, 2 }));
+    assert(loaded(2) == 4);
+    assert(evaluations == 3);
+
+    // The shared cache keeps the values it already has
+    snapshot.clear();
+    snapshot.str("2 0\n5 25\n");
+    shared_cache_type shared(square_or_absent, 3);
+    shared(2);
+    assert(shared.load(snapshot, read_pair) == 2);
+    assert(shared(2) == 4);
+    assert(shared(5) == 25);
+    assert(evaluations == 4);
+
+    // A snapshot may be loaded while one of its keys is being
+    // evaluated: the evaluation returns its own value, but
+    // the loaded one is kept
+    shared_cache_type* reloaded = nullptr;
+    shared_cache_type loading_cache(
+        [&reloaded](const int& k) {
+            std::stringstream s("7 70\n");
+            reloaded->load(s, read_pair);
+            return square_or_absent(k);
+        },
+        3
+    );
+    reloaded = &loading_cache;
+    assert(loading_cache(7) == 49);
+    assert(loading_cache(7) == 70);
+}
+
+std::string serialize_int(const int& v)
+{
+    return std::to_string(v);
+}
+
+int deserialize_int(const std::string& s)
+{
+    return std::stoi(s);
+}
+
+void test_disk_tier()
+{
+    typedef disk_tier_using_std<int, int, std::unordered_map> disk_tier_type;
+
+    const auto tier = std::make_shared<disk_tier_type>(
+        "lru_cache_behavior_test.tier", 16, serialize_int, deserialize_int, 2
+    );
+
+    // Pairs can be taken back whether queued or written
+    for (int k = 0; k < 6; ++k) {
+        tier->put(k, k * k);
+    }
+    tier->flush();
+    tier->put(6, 36);
+    assert(tier->size() == 6);
+    assert(*tier->take(2) == 4);
+    assert(!tier->take(2));
+    assert(*tier->take(6) == 36);
+
+    // Invalidation reaches both queued and written pairs
+    tier->put(7, 49);
+    assert(tier->erase(7));
+    assert(tier->erase(1));
+    assert(!tier->erase(1));
+    tier->put(8, 64);
+    assert(tier->erase_if([](const int& k, const int&) { return k % 2 == 0; }) == 3);
+    assert(tier->size() == 2);
+    assert(*tier->take(3) == 9);
+    assert(!tier->take(4));
+    tier->clear();
+    assert(tier->size() == 0);
+    assert(!tier->take(5));
+
+    // In front of a cache: evictions go to the tier, and
+    // misses are answered from there
+    int offset = 0;
+    evaluations = 0;
+    shared_cache_type cache(
+        with_disk_tier<int, int, std::unordered_map>(
+            tier,
+            [&offset](const int& k) { return square_or_absent(k) + offset; }
+        ),
+        1
+    );
+    cache.set_removal_listener(
+        [tier](const std::vector<shared_cache_type::removal>& removals) {
+            for (const auto& r : removals) {
+                if (r.cause == shared_cache_type::removal_cause::size) {
+                    tier->put(r.key, r.value);
+                }
+            }
+        }
+    );
+    assert(cache(1) == 1);
+    assert(cache(2) == 4);
+    assert(cache(1) == 1);
+    assert(evaluations == 2);
+
+    // Once erased, a key is evaluated again, even if its
+    // old value was in the tier
+    offset = 100;
+    assert(!erase_with_disk_tier(cache, *tier, 2));
+    assert(cache(2) == 104);
+    assert(erase_with_disk_tier(cache, *tier, 2));
+    assert(cache(1) == 1);
+    assert(cache(2) == 104);
+    assert(evaluations == 4);
+
+    // A key put again while its previous value is being
+    // written is gone for good once erased. The serializer
+    // holds the write until the key has been put and erased.
+    std::promise<void> writing;
+    std::promise<void> may_write;
+    std::shared_future<void> may_write_future = may_write.get_future().share();
+    bool fail_writes = false;
+    disk_tier_type slow_tier(
+        "lru_cache_behavior_test.slow_tier", 16,
+        [&](const int& v) {
+            if (fail_writes) {
+                throw std::runtime_error("Unable to serialize");
+            }
+            if (v == 10) {
+                writing.set_value();
+                may_write_future.wait();
+            }
+            return serialize_int(v);
+        },
+        deserialize_int, 16
+    );
+    slow_tier.put(1, 10);
+    std::future<void> flushed = std::async(std::launch::async, [&slow_tier]() { slow_tier.flush(); });
+    writing.get_future().wait();
+    slow_tier.put(1, 11);
+    assert(slow_tier.erase(1));
+    may_write.set_value();
+    flushed.get();
+    slow_tier.flush();
+    assert(!slow_tier.take(1));
+    assert(slow_tier.size() == 0);
+
+    // A batch that fails to be written is dropped
+    slow_tier.put(2, 20);
+    fail_writes = true;
+    bool threw = false;
+    try {
+        slow_tier.flush();
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    fail_writes = false;
+    assert(!slow_tier.take(2));
+    slow_tier.put(3, 30);
+    slow_tier.flush();
+    assert(*slow_tier.take(3) == 30);
+}
+
+// Writes 13 as a record that cannot be read back, and throws
+// something other than an exception for 99 
+std::string serialize_int_or_fail(const int& v)
+{
+    if (v == 99) {
+        throw v;
+    }
+    return v == 13 ? "x" : serialize_int(v);
+}
+
+void test_disk_tier_failures()
+{
+    typedef disk_tier_using_std<int, int, std::unordered_map> disk_tier_type;
+
+    const auto tier = std::make_shared<disk_tier_type>(
+        "lru_cache_behavior_test.failing_tier", 16, serialize_int_or_fail, deserialize_int, 16
+    );
+
+    // If the serializer throws, the older record of the key is
+    // dropped along with the batch
+    tier->put(5, 25);
+    tier->flush();
+    tier->put(5, 99);
+    bool threw = false;
+    try {
+        tier->flush();
+    }
+    catch (...) {
+        threw = true;
+    }
+    assert(threw);
+    assert(!tier->take(5));
+
+    // The writer thread outlives a serializer that throws
+    {
+        disk_tier_type background_tier(
+            "lru_cache_behavior_test.background_tier", 16, serialize_int_or_fail, deserialize_int, 1
+        );
+        background_tier.put(6, 99);
+        std::this_thread::sleep_for(std::chrono::milliseconds(100));
+        background_tier.put(7, 49);
+        try {
+            background_tier.flush();
+        }
+        catch (...) {
+        }
+        assert(*background_tier.take(7) == 49);
+    }
+
+    // A record that cannot be read is a miss for the cache
+    evaluations = 0;
+    shared_cache_type cache(with_disk_tier<int, int, std::unordered_map>(tier, square_or_absent), 4);
+    tier->put(13, 13);
+    tier->flush();
+    assert(cache(13) == 169);
+    assert(evaluations == 1);
+
+#if defined(__unix__)
+    // A batch that cannot be written to the file is dropped,
+    // with the older records of its keys, and the tier works
+    // again once the file can be written. The file size limit
+    // makes the writes fail.
+    disk_tier_type full_tier("lru_cache_behavior_test.full_tier", 16, serialize_int, deserialize_int, 16);
+    full_tier.put(1, 1);
+    full_tier.flush();
+
+    rlimit original_limit;
+    getrlimit(RLIMIT_FSIZE, &original_limit);
+    rlimit limit = original_limit;
+    limit.rlim_cur = 4;
+    const auto original_handler = std::signal(SIGXFSZ, SIG_IGN);
+    setrlimit(RLIMIT_FSIZE, &limit);
+
+    full_tier.put(1, 1000000);
+    full_tier.put(2, 2000000);
+    threw = false;
+    try {
+        full_tier.flush();
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+
+    setrlimit(RLIMIT_FSIZE, &original_limit);
+    std::signal(SIGXFSZ, original_handler);
+
+    assert(threw);
+    assert(!full_tier.take(1));
+    assert(!full_tier.take(2));
+    assert(full_tier.size() == 0);
+    full_tier.put(3, 30);
+    full_tier.flush();
+    assert(full_tier.size() == 1);
+    assert(*full_tier.take(3) == 30);
+#endif
+}
+
+void test_mapped_snapshot()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+    typedef mapped_snapshot<int, int> snapshot_type;
+
+    const std::string path = "lru_cache_behavior_test.snapshot";
+
+    evaluations = 0;
+    lru_cache_type saved(square_or_absent, 4);
+    for (int k = 1; k <= 4; ++k) {
+        saved(k);
+    }
+    snapshot_type::write(path, saved);
+
+    {
+        const auto snapshot = std::make_shared<snapshot_type>(path);
+        assert(snapshot->size() == 4);
+        assert(*snapshot->find(3) == 9);
+        assert(!snapshot->find(5));
+
+        // Values found in the snapshot are not evaluated, until
+        // erased from both the snapshot and the cache
+        int offset = 0;
+        shared_cache_type cache(
+            with_mapped_snapshot<int, int>(
+                snapshot,
+                [&offset](const int& k) { return square_or_absent(k) + offset; }
+            ),
+            4
+        );
+        assert(cache(2) == 4);
+        assert(cache(5) == 25);
+        assert(evaluations == 5);
+        offset = 100;
+        assert(erase_with_mapped_snapshot(cache, *snapshot, 2));
+        assert(!snapshot->find(2));
+        assert(cache(2) == 104);
+        assert(snapshot->erase_if([](const int& k, const int&) { return k > 3; }) == 1);
+        assert(cache(4) == 116);
+        assert(cache(1) == 1);
+        snapshot->clear();
+        assert(!snapshot->find(1) && !snapshot->find(3));
+        assert(snapshot->size() == 4);
+        assert(evaluations == 7);
+    }
+
+    // A record count that does not fit in the file is rejected,
+    // even if multiplying it by the record size would overflow
+    {
+        std::fstream file(path, std::ios::in | std::ios::out | std::ios::binary);
+        snapshot_type::header_type header;
+        file.read(reinterpret_cast<char*>(&header), sizeof(header));
+        header.count = std::numeric_limits<uint64_t>::max() / sizeof(snapshot_type::record_type) + 1;
+        file.seekp(0);
+        file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+    }
+    bool rejected = false;
+    try {
+        snapshot_type snapshot(path);
+    }
+    catch (const std::runtime_error&) {
+        rejected = true;
+    }
+    assert(rejected);
+
+    std::remove(path.c_str());
+}
+
+void test_arc_cache()
+{
+    typedef arc_cache_using_std<int, int, std::unordered_map> arc_cache_type;
+
+    evaluations = 0;
+    arc_cache_type cache(square_or_absent, 4);
+
+    // Keys seen twice move from T1 to T2
+    cache(1);
+    cache(2);
+    assert(cache.get_list_size(arc_cache_type::t1) == 2);
+    cache(1);
+    cache(2);
+    assert(cache.get_list_size(arc_cache_type::t1) == 0);
+    assert(cache.get_list_size(arc_cache_type::t2) == 2);
+
+    // A scan of keys seen once only replaces keys in T1
+    for (int k = 100; k < 120; ++k) {
+        cache(k);
+    }
+    assert(cache.has(1) && cache.has(2));
+    assert(cache.get_target_t1_size() == 0);
+    assert(cache.get_list_size(arc_cache_type::b1) > 0);
+    assert(evaluations == 22);
+
+    // A hit on a key recently evicted from T1 means that T1
+    // should have been larger
+    cache(117);
+    assert(evaluations == 23);
+    assert(cache.get_target_t1_size() == 1);
+    assert(cache.has(117));
+    assert(cache.get_list_size(arc_cache_type::t2) == 3);
+}
+
+void test_slru_cache()
+{
+    typedef slru_cache_using_std<int, int, std::unordered_map> slru_cache_type;
+
+    // Two protected slots, and three probationary ones
+    slru_cache_type cache(square_or_absent, 5, 0.4);
+
+    // A hit promotes a key to the protected segment
+    cache(1);
+    cache(2);
+    cache(3);
+    assert(cache.get_segment_size(slru_cache_type::probationary) == 3);
+    cache(1);
+    cache(2);
+    assert(cache.get_segment_size(slru_cache_type::protected_) == 2);
+
+    // Keys seen once cannot push out protected keys
+    for (int k = 100; k < 120; ++k) {
+        cache(k);
+    }
+    assert(cache.has(1) && cache.has(2));
+    assert(!cache.has(3));
+    assert(cache.get_segment_size(slru_cache_type::probationary) == 3);
+
+    // Promoting more keys than fit demotes the least recently
+    // used protected key, which then gets another chance as
+    // the most recently used probationary key
+    cache(119);
+    assert(cache.get_segment_size(slru_cache_type::protected_) == 2);
+    assert(cache.has(1));
+    cache(200);
+    cache(201);
+    assert(cache.has(1));
+    cache(202);
+    assert(!cache.has(1));
+    assert(cache.has(2) && cache.has(119));
+}
+
+void test_lfu_cache()
+{
+    typedef lfu_cache_using_std<int, int, std::unordered_map> lfu_cache_type;
+
+    lfu_cache_type cache(square_or_absent, 3);
+    for (int i = 0; i < 3; ++i) {
+        cache(1);
+    }
+    cache(2);
+    cache(2);
+    cache(3);
+    assert(cache.get_frequency(1) == 3);
+    assert(cache.get_frequency(2) == 2);
+    assert(cache.get_frequency(3) == 1);
+    assert((keys_of(cache) == std::vector<int> { 1, 2, 3 }));
+
+    // The least frequently used key goes first, however
+    // recently it was used
+    cache(4);
+    assert(!cache.has(3));
+
+    // Ties are broken by recency
+    cache(4);
+    cache(5);
+    assert(!cache.has(2));
+    assert(cache.has(4) && cache.has(5));
+    assert(cache.get_frequency(2) == 0);
+
+    // With aging, frequencies are halved once per period
+    lfu_cache_type aging_cache(square_or_absent, 2, 10);
+    for (int i = 0; i < 8; ++i) {
+        aging_cache(1);
+    }
+    aging_cache(2);
+    assert(aging_cache.get_frequency(1) == 8);
+    aging_cache(2);
+    assert(aging_cache.get_frequency(1) == 4);
+    assert(aging_cache.get_frequency(2) == 2);
+}
+
+void test_gdsf_cache()
+{
+    typedef gdsf_cache_using_std<int, int, std::unordered_map> gdsf_cache_type;
+
+    // Key 1 is ten times as expensive to evaluate as the others
+    gdsf_cache_type cache(
+        square_or_absent,
+        2,
+        gdsf_cache_type::size_function_type(),
+        [](const int& k, const int&) { return k == 1 ? 10.0 : 1.0; }
+    );
+
+    // At equal frequency, the cheap value goes first, although
+    // the expensive one was used less recently
+    cache(1);
+    cache(2);
+    cache(3);
+    assert(cache.has(1));
+    assert(!cache.has(2));
+    assert(cache.has(3));
+    assert(cache.get_evaluation_cost() == 12.0);
+
+    // Frequency makes up for cost: once hit often enough, a
+    // cheap value outlives the expensive one, whose priority
+    // also ages as others are evicted
+    for (int i = 0; i < 20; ++i) {
+        cache(3);
+    }
+    cache(4);
+    cache(5);
+    assert(cache.has(3));
+    assert(!cache.has(1));
+}
+
+int slow_square(const int& k)
+{
+    std::this_thread::sleep_for(std::chrono::milliseconds(20));
+    return square_or_absent(k);
+}
+
+void test_entry_cost()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+
+    // The plain cache keeps the cost given to set(); values
+    // that it evaluates itself, set() without a cost and load()
+    // give 0
+    lru_cache_type cache(slow_square, 4);
+    assert(cache(2) == 4);
+    assert(cache.get_cost(2) == 0.0);
+    cache.set(3, 9);
+    assert(cache.get_cost(3) == 0.0);
+    cache.set(5, 25, 1.5);
+    assert(cache.get_cost(5) == 1.5);
+    std::stringstream pairs("6 36\n");
+    assert(cache.load(pairs, read_pair) == 1);
+    assert(cache.get_cost(6) == 0.0);
+    assert(cache.get_cost(7) == 0.0);
+
+    // The shared cache keeps the time taken by the cached
+    // function as the cost of the entry, and times the
+    // evaluations as a whole
+    shared_cache_type shared(slow_square, 4);
+    assert(shared(2) == 4);
+    assert(shared.get_cost(2) >= 0.015);
+    assert(shared.get_load_stats().loads == 1);
+    assert(shared.get_load_stats().max_seconds >= 0.015);
+    std::stringstream shared_pairs("6 36\n");
+    assert(shared.load(shared_pairs, read_pair) == 1);
+    assert(shared.get_cost(6) == 0.0);
+}
+
+int freed_objects = 0;
+
+void free_object(void* p)
+{
+    delete static_cast<int*>(p);
+    ++freed_objects;
+}
+
+void test_epoch_reclaimer()
+{
+    epoch_reclaimer reclaimer(4);
+
+    // A pinned reader keeps objects retired meanwhile from
+    // being freed, however often collection is attempted
+    {
+        epoch_reclaimer::guard pinned(reclaimer);
+        reclaimer.retire(new int(1), free_object);
+        reclaimer.retire(new int(2), free_object);
+        for (int i = 0; i < 3; ++i) {
+            reclaimer.collect();
+        }
+        assert(reclaimer.retired() == 2);
+        assert(freed_objects == 0);
+    }
+
+    // Once it is done, the epoch can move on, and they are
+    // freed
+    reclaimer.collect();
+    assert(freed_objects == 2);
+    assert(reclaimer.retired() == 0);
+
+    // Objects retired from other threads are freed as well
+    std::thread other([&reclaimer]() { reclaimer.retire(new int(3), free_object); });
+    other.join();
+    reclaimer.collect();
+    reclaimer.collect();
+    assert(freed_objects == 3);
+}
+
+void test_numa_cache()
+{
+    typedef numa_lru_cache_using_std<int, int, std::unordered_map> numa_cache_type;
+
+    evaluations = 0;
+    numa_cache_type cache(square_or_absent, 8, true, 2);
+    assert(cache.get_node_count() == 2);
+    assert(cache.get_created_node_count() == 0);
+
+    // Only the cache of the calling thread's node is created
+    assert(cache(3) == 9);
+    assert(cache(3) == 9);
+    assert(evaluations == 1);
+    assert(cache.get_created_node_count() == 1);
+    assert(cache.get_hit_rate().hits == 1);
+
+    // Invalidations reach the created caches without creating
+    // the others
+    assert(cache.erase(3));
+    assert(!cache.erase(3));
+    assert(!cache.has(3));
+    assert(cache.get_created_node_count() == 1);
+    assert(cache(3) == 9);
+    assert(evaluations == 2);
+    cache.invalidate_all();
+    assert(!cache.has(3));
+    assert(cache.get_created_node_count() == 1);
+
+    // Keys need not be hashable, with or without cross-node
+    // lookups
+    numa_lru_cache_using_std<std::pair<int, int>, int, std::map> ordered(sum_of_pair, 8, true, 2);
+    assert(ordered(std::make_pair(1, 2)) == 3);
+    assert(ordered.has(std::make_pair(1, 2)));
+    numa_lru_cache_using_std<std::pair<int, int>, int, std::map> local_only(sum_of_pair, 8, false, 2);
+    assert(local_only(std::make_pair(2, 3)) == 5);
+}
+
+void test_removal_listener()
+{
+    typedef shared_cache_type::removal_cause removal_cause;
+
+    shared_cache_type cache(square_or_absent, 2);
+    std::vector<std::vector<shared_cache_type::removal> > batches;
+    cache.set_removal_listener(
+        [&batches](const std::vector<shared_cache_type::removal>& removals) {
+            batches.push_back(removals);
+        },
+        2
+    );
+
+    // Removals are held back until there is a full batch
+    cache(1);
+    cache(2);
+    cache(3);
+    assert(batches.empty());
+    cache.erase(2);
+    assert(batches.size() == 1);
+    assert(batches[0].size() == 2);
+    assert(batches[0][0].key == 1 && batches[0][0].value == 1);
+    assert(batches[0][0].cause == removal_cause::size);
+    assert(batches[0][1].key == 2 && batches[0][1].value == 4);
+    assert(batches[0][1].cause == removal_cause::explicit_removal);
+
+    // ... unless flushed
+    cache.invalidate_all();
+    assert(batches.size() == 1);
+    cache.flush_removals();
+    assert(batches.size() == 2);
+    assert(batches[1].size() == 1);
+    assert(batches[1][0].key == 3);
+    assert(batches[1][0].cause == removal_cause::explicit_removal);
+}
+
+template <typename CACHE>
+size_t key_count(const CACHE& cache)
+{
+    std::vector<int> keys;
+    cache.get_keys(std::back_inserter(keys));
+    return keys.size();
+}
+
+void test_invalidation()
+{
+    typedef lru_cache_using_std<int, int, std::unordered_map> lru_cache_type;
+    typedef lru_cache_type::removal_cause removal_cause;
+
+    lru_cache_type cache(square_or_absent, 8);
+    std::vector<std::pair<int, removal_cause> > removed;
+    cache.set_removal_callback(
+        [&removed](const int& k, const int&, removal_cause cause) {
+            removed.push_back(std::make_pair(k, cause));
+        }
+    );
+    for (int k = 1; k <= 6; ++k) {
+        cache(k);
+    }
+
+    // erase() removes only the given key, if present
+    assert(cache.erase(2));
+    assert(!cache.erase(2));
+    assert(!cache.has(2));
+    assert(key_count(cache) == 5);
+    assert(removed.size() == 1);
+    assert(removed[0].first == 2 && removed[0].second == removal_cause::explicit_removal);
+
+    // erase_if() removes the pairs that match, by value too
+    removed.clear();
+    assert(cache.erase_if([](const int&, const int& v) { return v > 10; }) == 3);
+    assert(cache.has(1) && cache.has(3));
+    assert(!cache.has(4) && !cache.has(5) && !cache.has(6));
+    assert(key_count(cache) == 2);
+    assert(removed.size() == 3);
+    for (const auto& r : removed) {
+        assert(r.first >= 4 && r.second == removal_cause::explicit_removal);
+    }
+
+    // invalidate_all() removes everything, notifying of each
+    removed.clear();
+    cache.invalidate_all();
+    assert(!cache.has(1) && !cache.has(3));
+    assert(key_count(cache) == 0);
+    assert(removed.size() == 2);
+    assert(removed[0].second == removal_cause::explicit_removal);
+    assert(removed[1].second == removal_cause::explicit_removal);
+
+    // clear() removes everything, without notifying
+    removed.clear();
+    cache(7);
+    cache(8);
+    cache.clear();
+    assert(!cache.has(7) && !cache.has(8));
+    assert(key_count(cache) == 0);
+    assert(removed.empty());
+
+    // The shared cache's erase_if() matches actual values, and
+    // the removed keys are evaluated again
+    evaluations = 0;
+    shared_cache_type shared(square_or_absent, 8);
+    std::vector<shared_cache_type::removal> shared_removed;
+    shared.set_removal_listener(
+        [&shared_removed](const std::vector<shared_cache_type::removal>& removals) {
+            shared_removed.insert(shared_removed.end(), removals.begin(), removals.end());
+        }
+    );
+    for (int k = 1; k <= 4; ++k) {
+        shared(k);
+    }
+    assert(shared.erase_if([](const int&, const int& v) { return v % 2 == 0; }) == 2);
+    assert(shared.has(1) && shared.has(3));
+    assert(!shared.has(2) && !shared.has(4));
+    assert(shared_removed.size() == 2);
+    for (const auto& r : shared_removed) {
+        assert(r.value % 2 == 0);
+        assert(r.cause == shared_cache_type::removal_cause::explicit_removal);
+    }
+    assert(shared(2) == 4);
+    assert(shared(3) == 9);
+    assert(evaluations == 5);
+
+    // A failure of an evaluation that spans erase(k) is not
+    // cached: the next call evaluates k again
+    std::promise<void> loading;
+    std::promise<void> may_fail;
+    std::shared_future<void> may_fail_future = may_fail.get_future().share();
+    std::atomic<int> loads(0);
+    shared_cache_type failing(
+        [&](const int& k) {
+            if (loads++ == 0) {
+                loading.set_value();
+                may_fail_future.wait();
+                throw std::runtime_error("Unable to load");
+            }
+            return k * k;
+        },
+        8
+    );
+    failing.enable_failure_caching(8, std::chrono::seconds(60));
+    std::future<int> failed = std::async(std::launch::async, [&failing]() { return failing(5); });
+    loading.get_future().wait();
+    failing.erase(5);
+    may_fail.set_value();
+    bool threw = false;
+    try {
+        failed.get();
+    }
+    catch (const std::runtime_error&) {
+        threw = true;
+    }
+    assert(threw);
+    assert(failing(5) == 25);
+    assert(loads == 2);
+    assert(failing.get_hit_rate().failure_hits == 0);
+}
+
+void call_cache_for_range(shared_cache_type& cache, int first_key)
+{
+    for (int i = 0; i < 200; ++i) {
+        cache(first_key + i % 50);
+    }
+}
+
+void test_reentrant_removal_listener()
+{
+    // The listener calls the cache, causing more removals,
+    // while two threads keep evicting each other's keys
+    const int listener_key_offset = 10000;
+    shared_cache_type cache(square_or_absent, 4);
+    cache.set_removal_listener(
+        [&cache](const std::vector<shared_cache_type::removal>& removals) {
+            for (const auto& r : removals) {
+                if (r.key < listener_key_offset) {
+                    assert(cache(r.key + listener_key_offset) == (r.key + listener_key_offset) * (r.key + listener_key_offset));
+                }
+            }
+        }
+    );
+
+    std::packaged_task<void()> task([&cache]() {
+        std::thread other(call_cache_for_range, std::ref(cache), 1000);
+        call_cache_for_range(cache, 0);
+        other.join();
+    });
+    std::future<void> done = task.get_future();
+    std::thread thread(std::move(task));
+
+    // A deadlock fails the test instead of hanging it
+    assert(done.wait_for(std::chrono::seconds(30)) == std::future_status::ready);
+    thread.join();
+}
+
+} // namespace
+
+int main()
+{
+    test_contains();
+    test_negative_caching();
+    test_promotion_policy();
+    test_recompute_tracking();
+    test_capacity_curve();
+    test_save_and_load();
+    test_disk_tier();
+    test_disk_tier_failures();
+    test_mapped_snapshot();
+    test_arc_cache();
+    test_slru_cache();
+    test_lfu_cache();
+    test_gdsf_cache();
+    test_entry_cost();
+    test_epoch_reclaimer();
+    test_numa_cache();
+    test_removal_listener();
+    test_invalidation();
+    test_reentrant_removal_listener();
+
+    std::cout << "All behavior tests passed" << std::endl;
+
+    return 0;
+}
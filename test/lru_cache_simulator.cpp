@@ -0,0 +1,271 @@
+#include "../lru_cache_using_std.h"
+#include "../arc_cache_using_std.h"
+#include "../slru_cache_using_std.h"
+#include "../lfu_cache_using_std.h"
+#include "../gdsf_cache_using_std.h"
+#include <unordered_map>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstdlib>
+#include <fstream>
+#include <iostream>
+#include <random>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Replays a key trace through one of the caches at several
+// capacities, and prints the resulting hit ratio curve as CSV.
+// The cached function is not real: it only counts misses.
+//
+// Usage: lru_cache_simulator <workload> [options]
+//
+// Workloads:
+//   trace <file>  keys read from a file, one per line
+//   zipf          keys drawn from a Zipfian distribution
+//   scan          zipf, interrupted by scans over unseen keys
+//   loop          keys 0, 1, ..., keys-1 repeated
+//   hotspot       most accesses go to a small hot set of keys,
+//                 which moves at regular intervals
+//
+// Options (with defaults):
+//   --keys 100000            number of distinct keys
+//   --length 1000000         number of accesses
+//   --zipf-exponent 0.99
+//   --scan-length 10000      length of each scan
+//   --scan-period 100000     accesses between scans
+//   --hot-keys 1000          size of the hot set
+//   --hot-fraction 0.9       fraction of accesses to the hot set
+//   --hot-period 100000      accesses between hot set moves
+//   --capacities a,b,...     default: powers of two up to keys
+//   --policy lru             lru, arc, slru, lfu or gdsf (with
+//                            the same cost for every miss)
+//   --seed 1
+
+namespace {
+
+typedef uint64_t key_type;
+typedef std::vector<key_type> trace_type;
+
+struct options {
+    std::string workload;
+    std::string trace_file;
+    size_t keys = 100000;
+    size_t length = 1000000;
+    double zipf_exponent = 0.99;
+    size_t scan_length = 10000;
+    size_t scan_period = 100000;
+    size_t hot_keys = 1000;
+    double hot_fraction = 0.9;
+    size_t hot_period = 100000;
+    std::vector<size_t> capacities;
+    std::string policy = "lru";
+    unsigned int seed = 1;
+};
+
+// Samples ranks 0..n-1 with probability proportional to
+// 1 / (rank + 1)^exponent
+class zipf_distribution {
+public:
+    zipf_distribution(size_t n, double exponent) {
+        _cdf.reserve(n);
+        double sum = 0.0;
+        for (size_t i = 0; i < n; ++i) {
+            sum += 1.0 / std::pow(static_cast<double>(i + 1), exponent);
+            _cdf.push_back(sum);
+        }
+        for (double& c : _cdf) {
+            c /= sum;
+        }
+    }
+
+    template <typename RNG> size_t operator()(RNG& rng) {
+        const double u = std::uniform_real_distribution<double>(0.0, 1.0)(rng);
+        const auto i = std::lower_bound(_cdf.begin(), _cdf.end(), u);
+        return std::min(static_cast<size_t>(i - _cdf.begin()), _cdf.size() - 1);
+    }
+
+private:
+    std::vector<double> _cdf;
+};
+
+trace_type read_trace(const std::string& path) {
+    std::ifstream in(path);
+    if (!in) {
+        std::cerr << "Unable to open trace file: " << path << std::endl;
+        std::exit(1);
+    }
+    // Number the distinct keys in order of appearance
+    std::unordered_map<std::string, key_type> ids;
+    trace_type trace;
+    std::string line;
+    while (std::getline(in, line)) {
+        const auto i = ids.insert(std::make_pair(line, static_cast<key_type>(ids.size())));
+        trace.push_back(i.first->second);
+    }
+    return trace;
+}
+
+trace_type generate_trace(const options& o) {
+    std::mt19937_64 rng(o.seed);
+    trace_type trace;
+    trace.reserve(o.length);
+
+    if (o.workload == "zipf" || o.workload == "scan") {
+        zipf_distribution zipf(o.keys, o.zipf_exponent);
+        // Scanned keys are never seen before, nor again
+        key_type next_scan_key = o.keys;
+        while (trace.size() < o.length) {
+            const bool scanning = o.workload == "scan" && o.scan_period > 0
+                && trace.size() % (o.scan_period + o.scan_length) >= o.scan_period;
+            trace.push_back(scanning ? next_scan_key++ : zipf(rng));
+        }
+    }
+    else if (o.workload == "loop") {
+        for (size_t i = 0; i < o.length; ++i) {
+            trace.push_back(i % o.keys);
+        }
+    }
+    else if (o.workload == "hotspot") {
+        std::uniform_real_distribution<double> fraction(0.0, 1.0);
+        std::uniform_int_distribution<size_t> any_key(0, o.keys - 1);
+        std::uniform_int_distribution<size_t> hot_key(0, o.hot_keys - 1);
+        size_t hot_start = 0;
+        for (size_t i = 0; i < o.length; ++i) {
+            if (i > 0 && o.hot_period > 0 && i % o.hot_period == 0) {
+                hot_start = any_key(rng);
+            }
+            trace.push_back(fraction(rng) < o.hot_fraction
+                ? (hot_start + hot_key(rng)) % o.keys
+                : any_key(rng));
+        }
+    }
+    else {
+        std::cerr << "Unknown workload: " << o.workload << std::endl;
+        std::exit(1);
+    }
+    return trace;
+}
+
+// Fraction of accesses that hit a cache of the given capacity;
+// any further arguments are passed to the constructor
+template <typename CACHE, typename... ARGS>
+double simulate(const trace_type& trace, size_t capacity, ARGS... args) {
+    size_t misses = 0;
+    CACHE cache(
+        [&misses](const key_type&) {
+            ++misses;
+            return char();
+        },
+        capacity,
+        args...
+    );
+    for (key_type k : trace) {
+        cache(k);
+    }
+    return trace.empty() ? 0.0 : 1.0 - static_cast<double>(misses) / trace.size();
+}
+
+std::vector<size_t> parse_capacities(const std::string& list) {
+    std::vector<size_t> capacities;
+    std::istringstream in(list);
+    std::string item;
+    while (std::getline(in, item, ',')) {
+        capacities.push_back(static_cast<size_t>(std::strtoull(item.c_str(), nullptr, 10)));
+    }
+    return capacities;
+}
+
+options parse_options(int argc, char* argv[]) {
+    options o;
+    if (argc < 2) {
+        std::cerr << "Usage: " << argv[0] << " trace <file> | zipf | scan | loop | hotspot [options]" << std::endl;
+        std::exit(1);
+    }
+    int i = 1;
+    o.workload = argv[i++];
+    if (o.workload == "trace") {
+        if (i >= argc) {
+            std::cerr << "Missing trace file" << std::endl;
+            std::exit(1);
+        }
+        o.trace_file = argv[i++];
+    }
+    for (; i + 1 < argc; i += 2) {
+        const std::string name = argv[i];
+        const char* value = argv[i + 1];
+        if (name == "--keys") o.keys = std::strtoull(value, nullptr, 10);
+        else if (name == "--length") o.length = std::strtoull(value, nullptr, 10);
+        else if (name == "--zipf-exponent") o.zipf_exponent = std::atof(value);
+        else if (name == "--scan-length") o.scan_length = std::strtoull(value, nullptr, 10);
+        else if (name == "--scan-period") o.scan_period = std::strtoull(value, nullptr, 10);
+        else if (name == "--hot-keys") o.hot_keys = std::strtoull(value, nullptr, 10);
+        else if (name == "--hot-fraction") o.hot_fraction = std::atof(value);
+        else if (name == "--hot-period") o.hot_period = std::strtoull(value, nullptr, 10);
+        else if (name == "--capacities") o.capacities = parse_capacities(value);
+        else if (name == "--policy") o.policy = value;
+        else if (name == "--seed") o.seed = static_cast<unsigned int>(std::atoi(value));
+        else {
+            std::cerr << "Unknown option: " << name << std::endl;
+            std::exit(1);
+        }
+    }
+    if (i < argc) {
+        std::cerr << "Missing value for option: " << argv[i] << std::endl;
+        std::exit(1);
+    }
+    if (o.policy != "lru" && o.policy != "arc" && o.policy != "slru" && o.policy != "lfu" && o.policy != "gdsf") {
+        std::cerr << "Unknown policy: " << o.policy << std::endl;
+        std::exit(1);
+    }
+    if (o.keys == 0 || o.hot_keys == 0) {
+        std::cerr << "Number of keys must be positive" << std::endl;
+        std::exit(1);
+    }
+    return o;
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    options o = parse_options(argc, argv);
+
+    const trace_type trace = o.workload == "trace"
+        ? read_trace(o.trace_file)
+        : generate_trace(o);
+
+    if (o.capacities.empty()) {
+        const size_t distinct_keys = trace.empty()
+            ? 1
+            : static_cast<size_t>(*std::max_element(trace.begin(), trace.end()) + 1);
+        for (size_t c = 1; c < distinct_keys; c *= 2) {
+            o.capacities.push_back(c);
+        }
+        o.capacities.push_back(distinct_keys);
+    }
+
+    // The cached function takes no time, so GDSF is given a
+    // constant cost instead of the evaluation time
+    typedef gdsf_cache_using_std<key_type, char, std::unordered_map> gdsf_cache_type;
+    const gdsf_cache_type::cost_function_type unit_cost = [](const key_type&, const char&) {
+        return 1.0;
+    };
+
+    std::cout << "capacity,hit_ratio" << std::endl;
+    for (size_t capacity : o.capacities) {
+        if (capacity == 0) {
+            continue;
+        }
+        const double hit_ratio
+            = o.policy == "arc" ? simulate<arc_cache_using_std<key_type, char, std::unordered_map>>(trace, capacity)
+            : o.policy == "slru" ? simulate<slru_cache_using_std<key_type, char, std::unordered_map>>(trace, capacity)
+            : o.policy == "lfu" ? simulate<lfu_cache_using_std<key_type, char, std::unordered_map>>(trace, capacity)
+            : o.policy == "gdsf" ? simulate<gdsf_cache_type>(trace, capacity, gdsf_cache_type::size_function_type(), unit_cost)
+            : simulate<lru_cache_using_std<key_type, char, std::unordered_map>>(trace, capacity);
+        std::cout << capacity << "," << hit_ratio << std::endl;
+    }
+
+    return 0;
+}
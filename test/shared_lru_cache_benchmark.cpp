@@ -0,0 +1,240 @@
+#include "../shared_lru_cache_using_std.h"
+#include "../concurrent_lru_cache_using_std.h"
+#include <map>
+#include <unordered_map>
+#include <chrono>
+#include <cstdint>
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+// Measures the cost of the caches themselves (the cached
+// function is trivial) for hits, misses, evictions, and a
+// mixed workload, across key types, map types, capacities and
+// thread counts. Results are written to stdout as JSON; with
+// several threads, ns_per_op is the wall-clock time divided by
+// the total number of operations.
+//
+// Usage: shared_lru_cache_benchmark [operations-per-thread]
+
+namespace {
+
+// Cheap per-thread random numbers
+struct xorshift {
+    explicit xorshift(uint64_t seed) : state(seed * 0x9E3779B97F4A7C15ull + 1) {}
+    uint64_t operator()() {
+        state ^= state << 13;
+        state ^= state >> 7;
+        state ^= state << 17;
+        return state;
+    }
+    uint64_t state;
+};
+
+// Turns key indices into keys of the benchmarked type
+template <typename K> struct key_maker;
+
+template <> struct key_maker<int> {
+    static const char* name() { return "int"; }
+    static int make(size_t i) { return static_cast<int>(i); }
+};
+
+template <> struct key_maker<std::string> {
+    static const char* name() { return "string"; }
+    static std::string make(size_t i) {
+        std::ostringstream key;
+        key << "benchmark-key-" << i;
+        return key.str();
+    }
+};
+
+template <template<typename...> class MAP> struct map_name;
+template <> struct map_name<std::map> { static const char* get() { return "map"; } };
+template <> struct map_name<std::unordered_map> { static const char* get() { return "unordered_map"; } };
+
+enum workload {
+    hit,        // keys always in the cache
+    miss,       // new keys, cache never full
+    eviction,   // new keys, cache always full
+    mixed       // 90 % hits, 10 % new keys with evictions
+};
+
+const char* workload_name(workload w) {
+    switch (w) {
+    case hit: return "hit";
+    case miss: return "miss";
+    case eviction: return "eviction";
+    case mixed: return "mixed";
+    }
+    return "";
+}
+
+// Precomputed sequence of key indices for one thread
+std::vector<size_t> make_sequence(workload w, size_t capacity, size_t ops, size_t thread, size_t thread_count) {
+    std::vector<size_t> sequence;
+    sequence.reserve(ops);
+    xorshift rng(thread + 1);
+    // New keys are distinct across threads, and beyond the
+    // preloaded ones
+    size_t next_new_key = capacity + thread;
+    for (size_t i = 0; i < ops; ++i) {
+        const bool is_hit = w == hit || (w == mixed && rng() % 10 != 0);
+        if (is_hit) {
+            sequence.push_back(static_cast<size_t>(rng() % capacity));
+        }
+        else {
+            sequence.push_back(next_new_key);
+            next_new_key += thread_count;
+        }
+    }
+    return sequence;
+}
+
+bool first_result = true;
+
+void report(const char* cache, const char* key, const char* map, workload w, size_t capacity, size_t threads, size_t ops, double seconds) {
+    std::cout << (first_result ? "\n" : ",\n");
+    first_result = false;
+    std::cout << "  {\"cache\": \"" << cache << "\""
+        << ", \"key\": \"" << key << "\""
+        << ", \"map\": \"" << map << "\""
+        << ", \"workload\": \"" << workload_name(w) << "\""
+        << ", \"capacity\": " << capacity
+        << ", \"threads\": " << threads
+        << ", \"operations\": " << ops
+        << ", \"ns_per_op\": " << (seconds * 1e9 / ops)
+        << ", \"ops_per_second\": " << static_cast<uint64_t>(ops / seconds)
+        << "}";
+}
+
+template <typename K, typename V>
+V trivial_function(const K&) {
+    return V(42);
+}
+
+template <typename K, template<typename...> class MAP>
+void benchmark_lru(workload w, size_t capacity, size_t ops) {
+    typedef lru_cache_using_std<K, uint64_t, MAP> cache_type;
+
+    // Without evictions, the cache must have room for all keys
+    const size_t effective_capacity = w == miss ? capacity + ops : capacity;
+    cache_type cache(trivial_function<K, uint64_t>, effective_capacity);
+
+    std::vector<K> keys;
+    for (size_t i : make_sequence(w, capacity, ops, 0, 1)) {
+        keys.push_back(key_maker<K>::make(i));
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        cache(key_maker<K>::make(i));
+    }
+
+    uint64_t sum = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (const K& k : keys) {
+        sum += cache(k);
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum == 0) {
+        std::cerr << "unexpected result" << std::endl;
+    }
+    report("lru", key_maker<K>::name(), map_name<MAP>::get(), w, capacity, 1, ops, elapsed.count());
+}
+
+// Benchmarks one of the thread-safe caches
+template <typename K, template<typename...> class MAP, typename CACHE>
+void benchmark_threaded(const char* name, workload w, size_t capacity, size_t thread_count, size_t ops_per_thread) {
+    typedef CACHE cache_type;
+
+    const size_t total_ops = ops_per_thread * thread_count;
+    const size_t effective_capacity = w == miss ? capacity + total_ops : capacity;
+    cache_type cache(trivial_function<K, uint64_t>, effective_capacity);
+
+    std::vector<std::vector<K> > keys(thread_count);
+    for (size_t t = 0; t < thread_count; ++t) {
+        for (size_t i : make_sequence(w, capacity, ops_per_thread, t, thread_count)) {
+            keys[t].push_back(key_maker<K>::make(i));
+        }
+    }
+    for (size_t i = 0; i < capacity; ++i) {
+        cache(key_maker<K>::make(i));
+    }
+
+    std::atomic<size_t> ready(0);
+    std::atomic<bool> go(false);
+    std::atomic<uint64_t> sum(0);
+
+    std::vector<std::thread> threads;
+    for (size_t t = 0; t < thread_count; ++t) {
+        threads.push_back(std::thread([&, t]() {
+            ++ready;
+            while (!go) {
+                std::this_thread::yield();
+            }
+            uint64_t local_sum = 0;
+            for (const K& k : keys[t]) {
+                local_sum += cache(k);
+            }
+            sum += local_sum;
+        }));
+    }
+
+    while (ready < thread_count) {
+        std::this_thread::yield();
+    }
+    const auto start = std::chrono::steady_clock::now();
+    go = true;
+    for (auto& thread : threads) {
+        thread.join();
+    }
+    const std::chrono::duration<double> elapsed = std::chrono::steady_clock::now() - start;
+
+    if (sum == 0) {
+        std::cerr << "unexpected result" << std::endl;
+    }
+    report(name, key_maker<K>::name(), map_name<MAP>::get(), w, capacity, thread_count, total_ops, elapsed.count());
+}
+
+template <typename K, template<typename...> class MAP>
+void benchmark_all(size_t ops_per_thread) {
+    const workload workloads[] = { hit, miss, eviction, mixed };
+    const size_t capacities[] = { 100, 10000, 1000000 };
+    const size_t thread_counts[] = { 1, 2, 4, 8 };
+
+    for (workload w : workloads) {
+        for (size_t capacity : capacities) {
+            benchmark_lru<K, MAP>(w, capacity, ops_per_thread);
+            for (size_t thread_count : thread_counts) {
+                benchmark_threaded<K, MAP, shared_lru_cache_using_std<K, uint64_t, MAP> >(
+                    "shared", w, capacity, thread_count, ops_per_thread);
+                benchmark_threaded<K, MAP, concurrent_lru_cache_using_std<K, uint64_t, MAP> >(
+                    "concurrent", w, capacity, thread_count, ops_per_thread);
+            }
+        }
+    }
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+#ifndef NDEBUG
+    size_t ops_per_thread = 10000;
+#else
+    size_t ops_per_thread = 200000;
+#endif
+    if (argc > 1) {
+        ops_per_thread = static_cast<size_t>(std::strtoull(argv[1], nullptr, 10));
+    }
+
+    std::cout << "[";
+    benchmark_all<int, std::unordered_map>(ops_per_thread);
+    benchmark_all<int, std::map>(ops_per_thread);
+    benchmark_all<std::string, std::unordered_map>(ops_per_thread);
+    benchmark_all<std::string, std::map>(ops_per_thread);
+    std::cout << "\n]" << std::endl;
+
+    return 0;
+}
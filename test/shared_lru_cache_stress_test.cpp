@@ -0,0 +1,383 @@
+#include "../shared_lru_cache_using_std.h"
+#include "../concurrent_lru_cache_using_std.h"
+#include "../thread_local_cache_using_std.h"
+#include <unordered_map>
+#include <array>
+#include <atomic>
+#include <cstdint>
+#include <cstdlib>
+#include <iterator>
+#include <iostream>
+#include <random>
+#include <stdexcept>
+#include <vector>
+
+// Stress test for shared_lru_cache_using_std: many threads call
+// the cache for a small set of keys, while other threads erase
+// and invalidate. The cached function records its invocations,
+// so that the following can be checked:
+//   - each key is evaluated by at most one thread at a time
+//   - every value returned was computed for the right key
+//   - after erase(k), the cache never returns a value that was
+//     computed before the erase started
+//   - the hit rate counters add up with the evaluations
+//   - the load statistics count every evaluation
+//   - the cache never holds more than its capacity
+// Then concurrent_lru_cache_using_std is checked in the same
+// way (except for the statistics, which it does not keep),
+// while keys are also being evicted, and their nodes
+// reclaimed; and
+// thread_local_cache_using_std, for never returning a value
+// older than an erase() that has returned. Finally, a loader
+// that fails for a while, under many threads calling for the
+// same key, must be evaluated again once it has recovered.
+// Build with -DLRU_CACHE_SANITIZER=thread to also check for
+// data races, or with -DLRU_CACHE_SANITIZER=address to check
+// that reclaimed nodes are not used.
+//
+// Usage: shared_lru_cache_stress_test [duration-in-milliseconds]
+
+namespace {
+
+const int key_count = 64;
+const size_t capacity = 16;
+const int reader_count = 8;
+
+std::atomic<size_t> failures(0);
+
+#define STRESS_CHECK(condition) \
+    do { \
+        if (!(condition)) { \
+            ++failures; \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": check failed: " #condition << std::endl; \
+        } \
+    } while (false)
+
+struct value {
+    int key;
+    uint64_t version;
+};
+
+struct key_state {
+    std::atomic<int> active_evaluations { 0 };
+    std::atomic<size_t> evaluations { 0 };
+    std::atomic<size_t> overlaps { 0 };
+    std::atomic<uint64_t> version { 0 };
+
+    // Version of the last erase() that has returned
+    std::atomic<uint64_t> erased_version { 0 };
+};
+
+std::array<key_state, key_count> keys;
+std::atomic<size_t> total_evaluations(0);
+std::atomic<size_t> total_failures(0);
+
+struct loader_failure : std::runtime_error {
+    loader_failure() : std::runtime_error("loader failure") {}
+};
+
+value load(const int& k) {
+    key_state& state = keys[k];
+    if (++state.active_evaluations > 1) {
+        ++state.overlaps;
+    }
+    ++state.evaluations;
+    ++total_evaluations;
+
+    const uint64_t version = state.version.load();
+
+    // Vary the timing, to produce different interleavings
+    thread_local std::minstd_rand rng(std::hash<std::thread::id>()(std::this_thread::get_id()));
+    const unsigned int r = rng() % 100;
+    if (r < 10) {
+        std::this_thread::sleep_for(std::chrono::microseconds(r * 10));
+    }
+    else if (r < 50) {
+        std::this_thread::yield();
+    }
+
+    --state.active_evaluations;
+
+    if (r == 99) {
+        ++total_failures;
+        throw loader_failure();
+    }
+
+    const value v = { k, version };
+    return v;
+}
+
+typedef shared_lru_cache_using_std<int, value, std::unordered_map> cache_type;
+
+void read_keys(cache_type& cache, std::chrono::steady_clock::time_point end, unsigned int seed, std::atomic<size_t>& calls) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        // Skewed, so that there are both hits and misses
+        const int k = static_cast<int>(rng() % key_count) % (1 + static_cast<int>(rng() % key_count));
+        ++calls;
+        try {
+            const value v = cache(k);
+            STRESS_CHECK(v.key == k);
+        }
+        catch (const loader_failure&) {
+        }
+    }
+}
+
+void invalidate_keys(cache_type& cache, std::chrono::steady_clock::time_point end, unsigned int seed, std::atomic<size_t>& calls) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        const int k = static_cast<int>(rng() % key_count);
+        const uint64_t version = ++keys[k].version;
+        cache.erase(k);
+        ++calls;
+        try {
+            const value v = cache(k);
+            STRESS_CHECK(v.key == k);
+            STRESS_CHECK(v.version >= version);
+        }
+        catch (const loader_failure&) {
+        }
+        if (rng() % 1000 == 0) {
+            cache.invalidate_all();
+        }
+        std::this_thread::yield();
+    }
+}
+
+void check_capacity(cache_type& cache, std::chrono::steady_clock::time_point end) {
+    while (std::chrono::steady_clock::now() < end) {
+        size_t size = 0;
+        std::ostream unused(nullptr);
+        cache.save(unused, [&size](std::ostream&, const int&, const value&) { ++size; });
+        STRESS_CHECK(size <= capacity);
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+}
+
+typedef concurrent_lru_cache_using_std<int, value, std::unordered_map> concurrent_cache_type;
+
+void use_concurrent_cache(concurrent_cache_type& cache, std::chrono::steady_clock::time_point end, unsigned int seed) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        const int k = static_cast<int>(rng() % key_count) % (1 + static_cast<int>(rng() % key_count));
+        try {
+            STRESS_CHECK(cache(k).key == k);
+        }
+        catch (const loader_failure&) {
+        }
+        STRESS_CHECK(cache.size() <= capacity);
+    }
+}
+
+void invalidate_concurrent_keys(concurrent_cache_type& cache, std::chrono::steady_clock::time_point end, unsigned int seed) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        const int k = static_cast<int>(rng() % key_count);
+        const uint64_t version = ++keys[k].version;
+        cache.erase(k);
+        try {
+            const value v = cache(k);
+            STRESS_CHECK(v.key == k);
+            STRESS_CHECK(v.version >= version);
+        }
+        catch (const loader_failure&) {
+        }
+        std::this_thread::yield();
+    }
+}
+
+void stress_concurrent_cache(int duration_ms) {
+    concurrent_cache_type cache(load, capacity, 4);
+    for (key_state& state : keys) {
+        state.overlaps = 0;
+    }
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < reader_count; ++i) {
+        threads.push_back(std::thread(use_concurrent_cache, std::ref(cache), end, i + 1));
+    }
+    threads.push_back(std::thread(invalidate_concurrent_keys, std::ref(cache), end, 1000));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t overlaps = 0;
+    for (const key_state& state : keys) {
+        overlaps += state.overlaps;
+    }
+    STRESS_CHECK(overlaps == 0);
+
+    // The index and the LRU list must agree
+    std::vector<int> cached;
+    cache.get_keys(std::back_inserter(cached));
+    size_t present = 0;
+    for (int k = 0; k < key_count; ++k) {
+        if (cache.has(k)) {
+            ++present;
+        }
+    }
+    STRESS_CHECK(cached.size() == present);
+    STRESS_CHECK(cached.size() <= capacity);
+}
+
+typedef thread_local_cache_using_std<int, value, std::unordered_map> l1_cache_type;
+
+void read_keys_through_l1(l1_cache_type& l1, std::chrono::steady_clock::time_point end, unsigned int seed) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        const int k = static_cast<int>(rng() % key_count) % (1 + static_cast<int>(rng() % key_count));
+        const uint64_t erased_version = keys[k].erased_version.load();
+        try {
+            const value v = l1(k);
+            STRESS_CHECK(v.key == k);
+            STRESS_CHECK(v.version >= erased_version);
+        }
+        catch (const loader_failure&) {
+        }
+    }
+}
+
+void erase_keys_under_l1(cache_type& cache, std::chrono::steady_clock::time_point end, unsigned int seed) {
+    std::minstd_rand rng(seed);
+    while (std::chrono::steady_clock::now() < end) {
+        const int k = static_cast<int>(rng() % key_count);
+        const uint64_t version = ++keys[k].version;
+        cache.erase(k);
+        keys[k].erased_version.store(version);
+        std::this_thread::sleep_for(std::chrono::microseconds(100));
+    }
+}
+
+void stress_thread_local_cache(int duration_ms) {
+    cache_type cache(load, capacity);
+    l1_cache_type l1(cache, 16);
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < reader_count; ++i) {
+        threads.push_back(std::thread(read_keys_through_l1, std::ref(l1), end, i + 1));
+    }
+    threads.push_back(std::thread(erase_keys_under_l1, std::ref(cache), end, 1000));
+    for (auto& thread : threads) {
+        thread.join();
+    }
+}
+
+std::atomic<bool> loader_recovered(false);
+std::atomic<size_t> evaluations_after_recovery(0);
+
+value load_after_recovery(const int& k) {
+    if (!loader_recovered.load()) {
+        throw loader_failure();
+    }
+    ++evaluations_after_recovery;
+    const value v = { k, 0 };
+    return v;
+}
+
+void read_hot_key(cache_type& cache, std::chrono::steady_clock::time_point end, std::atomic<size_t>& recovered_readers) {
+    while (std::chrono::steady_clock::now() < end) {
+        try {
+            STRESS_CHECK(cache(0).key == 0);
+            ++recovered_readers;
+            return;
+        }
+        catch (const loader_failure&) {
+        }
+    }
+}
+
+void stress_failure_recovery() {
+    const int hot_key_reader_count = 16;
+
+    cache_type cache(load_after_recovery, capacity);
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::seconds(10);
+    std::atomic<size_t> recovered_readers(0);
+    std::vector<std::thread> threads;
+    for (int i = 0; i < hot_key_reader_count; ++i) {
+        threads.push_back(std::thread(read_hot_key, std::ref(cache), end, std::ref(recovered_readers)));
+    }
+    std::this_thread::sleep_for(std::chrono::milliseconds(100));
+    loader_recovered.store(true);
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    STRESS_CHECK(evaluations_after_recovery > 0);
+    STRESS_CHECK(recovered_readers == hot_key_reader_count);
+}
+
+} // namespace
+
+int main(int argc, char* argv[])
+{
+    const int duration_ms = argc > 1 ? std::atoi(argv[1]) : 2000;
+
+    cache_type cache(load, capacity);
+
+    const auto end = std::chrono::steady_clock::now() + std::chrono::milliseconds(duration_ms);
+    std::atomic<size_t> calls(0);
+
+    std::vector<std::thread> threads;
+    for (int i = 0; i < reader_count; ++i) {
+        threads.push_back(std::thread(read_keys, std::ref(cache), end, i + 1, std::ref(calls)));
+    }
+    threads.push_back(std::thread(invalidate_keys, std::ref(cache), end, 1000, std::ref(calls)));
+    threads.push_back(std::thread(check_capacity, std::ref(cache), end));
+
+    for (auto& thread : threads) {
+        thread.join();
+    }
+
+    size_t overlaps = 0;
+    for (const key_state& state : keys) {
+        overlaps += state.overlaps;
+    }
+    STRESS_CHECK(overlaps == 0);
+
+    // Every call is a hit, a late hit, a shared failure, or
+    // an evaluation
+    const cache_type::hit_rate hit_rate = cache.get_hit_rate();
+    STRESS_CHECK(hit_rate.calls == calls);
+    STRESS_CHECK(hit_rate.negative_hits == 0);
+    STRESS_CHECK(hit_rate.hits + hit_rate.late_hits + hit_rate.failure_hits + total_evaluations == hit_rate.calls);
+
+    const cache_type::load_stats load_stats = cache.get_load_stats();
+    STRESS_CHECK(load_stats.loads == total_evaluations);
+    STRESS_CHECK(load_stats.failures == total_failures);
+    STRESS_CHECK(load_stats.max_seconds <= load_stats.total_seconds);
+
+    // No evaluation may have been left registered: every key
+    // must still be usable
+    for (int k = 0; k < key_count; ++k) {
+        for (;;) {
+            try {
+                STRESS_CHECK(cache(k).key == k);
+                break;
+            }
+            catch (const loader_failure&) {
+            }
+        }
+    }
+
+    std::cout << "calls: " << hit_rate.calls
+        << ", hits: " << hit_rate.hits
+        << ", late hits: " << hit_rate.late_hits
+        << ", shared failures: " << hit_rate.failure_hits
+        << ", evaluations: " << total_evaluations
+        << ", loader failures: " << total_failures
+        << std::endl;
+
+    stress_concurrent_cache(duration_ms);
+    stress_thread_local_cache(duration_ms);
+    stress_failure_recovery();
+
+    if (failures > 0) {
+        std::cerr << failures << " checks failed" << std::endl;
+        return 1;
+    }
+    return 0;
+}
@@ -1,7 +1,10 @@
 #include "../shared_lru_cache_using_std.h"
 #include <unordered_map>
+#include <cassert>
+#include <cstdint>
 #include <iostream>
 #include <iomanip>
+#include <vector>
 
 typedef shared_lru_cache_using_std<int, uint64_t, std::unordered_map> cache;
 
@@ -46,7 +49,7 @@ void calculate(int n, cache* cache)
     }
 }
 
-int main(int argc, char* argv[])
+int main()
 {
     std::cout << "Let's spend some system resources..." << std::endl;
 
@@ -0,0 +1,174 @@
+/******************************************************************************/
+/*  Copyright (c) 2026, the lru_cache_using_std contributors                  */
+/*                                                                            */
+/*  Permission to use, copy, modify, and/or distribute this software for any  */
+/*  purpose with or without fee is hereby granted, provided that the above    */
+/*  copyright notice and this permission notice appear in all copies.         */
+/*                                                                            */
+/*  THE SOFTWARE IS PROVIDED "AS IS" AND THE AUTHOR DISCLAIMS ALL WARRANTIES  */
+/*  WITH REGARD TO THIS SOFTWARE INCLUDING ALL IMPLIED WARRANTIES OF          */
+/*  MERCHANTABILITY AND FITNESS. IN NO EVENT SHALL THE AUTHOR BE LIABLE FOR   */
+/*  ANY SPECIAL, DIRECT, INDIRECT, OR CONSEQUENTIAL DAMAGES OR ANY DAMAGES    */
+/*  WHATSOEVER RESULTING FROM LOSS OF USE, DATA OR PROFITS, WHETHER IN AN     */
+/*  ACTION OF CONTRACT, NEGLIGENCE OR OTHER TORTIOUS ACTION, ARISING OUT OF   */
+/*  OR IN CONNECTION WITH THE USE OR PERFORMANCE OF THIS SOFTWARE.            */
+/******************************************************************************/
+
+#ifndef _thread_local_cache_using_std_ 
+#define _thread_local_cache_using_std_ 
+
+#include "shared_lru_cache_using_std.h"
+#include "fibonacci_hash.h"
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// A small per-thread cache in front of a
+// shared_lru_cache_using_std: each thread has its own
+// direct-mapped table of recently returned key-value pairs,
+// which is consulted first, without any locking or writes to
+// shared memory. Misses (and collisions) go to the shared cache.
+//
+// Entries are tagged with the invalidation version of the
+// shared cache (read before calling it), and are only used
+// while that version is unchanged; so after erase(),
+// erase_if(), invalidate_all() or clear() has returned, no
+// thread will get an older value from its table. Note that any
+// invalidation drops the entries of all keys. Evictions from
+// the shared cache do not affect the tables. 
+//
+// Keys are compared with operator==. A thread keeps its table
+// until it exits or next uses a different instance after this
+// one is destroyed. 
+template <
+    typename K,
+    typename V,
+    template<typename...> class MAP
+> class thread_local_cache_using_std
+{
+public:
+
+    typedef K key_type;
+    typedef V value_type;
+
+    typedef shared_lru_cache_using_std<key_type, value_type, MAP> shared_cache_type;
+
+    // Constructor specifies the shared cache, which must outlive
+    // this object, and the number of entries in each table 
+    // (rounded up to a power of two) 
+    explicit thread_local_cache_using_std(
+        shared_cache_type& shared,
+        size_t slots = 64
+    )
+        : _shared(shared)
+        , _slot_bits(slot_bits_for(slots))
+        , _instance(next_instance()++)
+        , _alive(std::make_shared<char>(0))
+    {
+    }
+
+    // Obtain value of the cached function for k 
+    value_type operator()(const key_type& k) {
+        table_type& table = thread_table();
+        slot& s = table[slot_for(k)];
+
+        const uint64_t version = _shared.get_invalidation_version();
+        if (s.entry && s.version == version && s.entry->first == k) {
+            return s.entry->second;
+        }
+
+        const value_type v = _shared(k);
+        s.entry.reset(new std::pair<key_type, value_type>(k, v));
+        s.version = version;
+        return v;
+    }
+
+    shared_cache_type& shared() {
+        return _shared;
+    }
+
+private:
+
+    thread_local_cache_using_std(const thread_local_cache_using_std&);
+    thread_local_cache_using_std& operator=(const thread_local_cache_using_std&);
+
+    struct slot {
+        uint64_t version = 0;
+        std::unique_ptr<std::pair<key_type, value_type> > entry;
+    };
+
+    typedef std::vector<slot> table_type;
+
+    // The table of one thread for one instance; alive expires
+    // when the instance is destroyed 
+    struct thread_table_type {
+        uint64_t instance;
+        std::weak_ptr<char> alive;
+        table_type table;
+    };
+
+    static unsigned int slot_bits_for(size_t slots) {
+        unsigned int bits = 1;
+        while ((size_t(1) << bits) < slots) {
+            ++bits;
+        }
+        return bits;
+    }
+
+    size_t slot_for(const key_type& k) const {
+        return fibonacci_hash(k, _slot_bits);
+    }
+
+    // Instances are numbered, rather than identified by their
+    // address, which a later instance could reuse 
+    static std::atomic<uint64_t>& next_instance() {
+        static std::atomic<uint64_t> instance(0);
+        return instance;
+    }
+
+    // The tables of the calling thread, for all instances 
+    static std::vector<thread_table_type>& thread_tables() {
+        thread_local std::vector<thread_table_type> tables;
+        return tables;
+    }
+
+    table_type& thread_table() {
+        std::vector<thread_table_type>& tables = thread_tables();
+        for (thread_table_type& t : tables) {
+            if (t.instance == _instance) {
+                return t.table;
+            }
+        }
+
+        // First use of this instance in this thread: drop the
+        // tables of destroyed instances, and add one 
+        for (size_t i = 0; i < tables.size(); ) {
+            if (tables[i].alive.expired()) {
+                if (i + 1 != tables.size()) {
+                    tables[i] = std::move(tables.back());
+                }
+                tables.pop_back();
+            }
+            else {
+                ++i;
+            }
+        }
+        thread_table_type t;
+        t.instance = _instance;
+        t.alive = _alive;
+        t.table.resize(size_t(1) << _slot_bits);
+        tables.push_back(std::move(t));
+        return tables.back().table;
+    }
+
+    shared_cache_type& _shared;
+
+    const unsigned int _slot_bits;
+    const uint64_t _instance;
+    const std::shared_ptr<char> _alive;
+};
+
+#endif // _thread_local_cache_using_std_